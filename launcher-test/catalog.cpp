@@ -0,0 +1,281 @@
+#include <cstring>
+#include <memory>
+
+#include "catalog.hpp"
+
+#include "executable.hpp"
+
+static const char catalog_magic[4]{'B', 'L', 'C', 'T'};
+static const uint16_t catalog_version = 1;
+
+static const int max_icon_size = 32;
+
+// little helpers for the catalog file
+template<class T>
+static void write_value(std::vector<uint8_t> &buf, const T &value) {
+    auto ptr = reinterpret_cast<const uint8_t *>(&value);
+    buf.insert(buf.end(), ptr, ptr + sizeof(T));
+}
+
+static void write_bytes(std::vector<uint8_t> &buf, const void *data, size_t len) {
+    auto ptr = static_cast<const uint8_t *>(data);
+    buf.insert(buf.end(), ptr, ptr + len);
+}
+
+static bool read_bytes(const std::vector<uint8_t> &buf, size_t &offset, void *data, size_t len) {
+    if(offset + len > buf.size())
+        return false;
+
+    memcpy(data, buf.data() + offset, len);
+    offset += len;
+    return true;
+}
+
+template<class T>
+static bool read_value(const std::vector<uint8_t> &buf, size_t &offset, T &value) {
+    return read_bytes(buf, offset, &value, sizeof(T));
+}
+
+static void copy_string(char *dest, const char *src, size_t len) {
+    strncpy(dest, src, len - 1);
+    dest[len - 1] = 0;
+}
+
+GameCatalog::GameCatalog(std::string filename) : filename(filename) {
+}
+
+bool GameCatalog::load() {
+    blit::File file(filename);
+
+    if(!file.is_open())
+        return false;
+
+    std::vector<uint8_t> buf(file.get_length());
+    if(file.read(0, buf.size(), reinterpret_cast<char *>(buf.data())) != int32_t(buf.size()))
+        return false;
+
+    size_t offset = 0;
+
+    char magic[4];
+    uint16_t version;
+    uint32_t count;
+
+    if(!read_bytes(buf, offset, magic, 4) || memcmp(magic, catalog_magic, 4) != 0)
+        return false;
+
+    // anything from a different version gets rebuilt
+    if(!read_value(buf, offset, version) || version != catalog_version || !read_value(buf, offset, count))
+        return false;
+
+    entries.clear();
+
+    for(uint32_t i = 0; i < count; i++) {
+        uint16_t pathLen;
+        if(!read_value(buf, offset, pathLen) || offset + pathLen > buf.size())
+            break;
+
+        std::string path(reinterpret_cast<const char *>(buf.data() + offset), pathLen);
+        offset += pathLen;
+
+        CatalogEntry entry;
+        uint8_t hasMetadata;
+
+        bool ok = read_value(buf, offset, entry.size)
+               && read_value(buf, offset, hasMetadata)
+               && read_bytes(buf, offset, entry.title, sizeof(entry.title))
+               && read_bytes(buf, offset, entry.author, sizeof(entry.author))
+               && read_bytes(buf, offset, entry.version, sizeof(entry.version))
+               && read_bytes(buf, offset, entry.category, sizeof(entry.category))
+               && read_value(buf, offset, entry.icon_w)
+               && read_value(buf, offset, entry.icon_h);
+
+        if(!ok)
+            break;
+
+        entry.has_metadata = hasMetadata != 0;
+        entry.icon.resize(entry.icon_w * entry.icon_h);
+
+        if(!read_bytes(buf, offset, entry.icon.data(), entry.icon.size() * sizeof(blit::Pen)))
+            break;
+
+        entries.emplace(std::move(path), std::move(entry));
+    }
+
+    dirty = false;
+    return true;
+}
+
+bool GameCatalog::save() {
+    std::vector<uint8_t> buf;
+
+    write_bytes(buf, catalog_magic, 4);
+    write_value(buf, catalog_version);
+    write_value(buf, uint32_t(entries.size()));
+
+    for(auto &[path, entry] : entries) {
+        write_value(buf, uint16_t(path.length()));
+        write_bytes(buf, path.data(), path.length());
+
+        write_value(buf, entry.size);
+        write_value(buf, uint8_t(entry.has_metadata));
+        write_bytes(buf, entry.title, sizeof(entry.title));
+        write_bytes(buf, entry.author, sizeof(entry.author));
+        write_bytes(buf, entry.version, sizeof(entry.version));
+        write_bytes(buf, entry.category, sizeof(entry.category));
+        write_value(buf, entry.icon_w);
+        write_value(buf, entry.icon_h);
+        write_bytes(buf, entry.icon.data(), entry.icon.size() * sizeof(blit::Pen));
+    }
+
+    blit::File file(filename, blit::OpenMode::write);
+
+    if(!file.is_open() || file.write(0, buf.size(), reinterpret_cast<const char *>(buf.data())) != int32_t(buf.size()))
+        return false;
+
+    dirty = false;
+    return true;
+}
+
+const CatalogEntry *GameCatalog::find(const std::string &path) const {
+    auto it = entries.find(path);
+    return it == entries.end() ? nullptr : &it->second;
+}
+
+const CatalogEntry *GameCatalog::update(const std::string &path, uint32_t size) {
+    auto it = entries.find(path);
+
+    // there's no modification time, so this is the best we've got
+    if(it != entries.end() && it->second.size == size)
+        return &it->second;
+
+    CatalogEntry entry;
+    entry.size = size;
+    entry.has_metadata = parse_file(path, entry);
+
+    dirty = true;
+
+    if(it != entries.end()) {
+        it->second = std::move(entry);
+        return &it->second;
+    }
+
+    return &entries.emplace(path, std::move(entry)).first->second;
+}
+
+void GameCatalog::remove_missing(const std::string &dir, std::function<bool(const std::string &name)> exists) {
+    auto it = entries.lower_bound(dir);
+
+    while(it != entries.end() && it->first.compare(0, dir.length(), dir) == 0) {
+        auto name = it->first.substr(dir.length());
+
+        // leave subdirectories alone
+        bool found = name.find('/') != std::string::npos || exists(name);
+
+        if(found)
+            ++it;
+        else {
+            it = entries.erase(it);
+            dirty = true;
+        }
+    }
+}
+
+bool read_game_header(blit::File &file, uint32_t &binOffset, uint32_t &binSize) {
+    uint32_t offset = 0;
+    BlitGameHeader header;
+
+    if(file.read(offset, sizeof(header), reinterpret_cast<char *>(&header)) != sizeof(header))
+        return false;
+
+    // skip relocation data
+    if(memcmp(&header, "RELO", 4) == 0) {
+        uint32_t numRelocs;
+        if(file.read(4, 4, reinterpret_cast<char *>(&numRelocs)) != 4)
+            return false;
+
+        offset = numRelocs * 4 + 8;
+
+        if(file.read(offset, sizeof(header), reinterpret_cast<char *>(&header)) != sizeof(header))
+            return false;
+    }
+
+    if(header.magic != blit_game_magic)
+        return false;
+
+    binOffset = offset;
+    binSize = header.end & 0x1FFFFFF;
+    return true;
+}
+
+bool GameCatalog::parse_file(const std::string &path, CatalogEntry &entry) {
+    blit::File file(path);
+
+    if(!file.is_open())
+        return false;
+
+    uint32_t binOffset, binSize;
+    if(!read_game_header(file, binOffset, binSize))
+        return false;
+
+    // metadata is after the binary
+    uint32_t offset = binOffset + binSize;
+
+    char metaHeader[10];
+    if(file.read(offset, 10, metaHeader) != 10 || memcmp(metaHeader, "BLITMETA", 8) != 0)
+        return false;
+
+    uint16_t metaLen;
+    memcpy(&metaLen, metaHeader + 8, 2);
+
+    if(metaLen < sizeof(RawMetadata))
+        return false;
+
+    std::unique_ptr<uint8_t[]> buf(new uint8_t[metaLen]);
+    if(file.read(offset + 10, metaLen, reinterpret_cast<char *>(buf.get())) != metaLen)
+        return false;
+
+    auto raw = reinterpret_cast<const RawMetadata *>(buf.get());
+    copy_string(entry.title, raw->title, sizeof(entry.title));
+    copy_string(entry.author, raw->author, sizeof(entry.author));
+    copy_string(entry.version, raw->version, sizeof(entry.version));
+
+    uint32_t ptr = sizeof(RawMetadata);
+
+    // optional type info
+    if(ptr + 8 + sizeof(RawTypeMetadata) <= metaLen && memcmp(buf.get() + ptr, "BLITTYPE", 8) == 0) {
+        ptr += 8;
+        auto type = reinterpret_cast<const RawTypeMetadata *>(buf.get() + ptr);
+        copy_string(entry.category, type->category, sizeof(entry.category));
+
+        ptr += sizeof(RawTypeMetadata) + type->num_filetypes * sizeof(type->filetypes[0]);
+    }
+
+    // icon is the first image, decode it now so the listing doesn't have to
+    if(ptr + sizeof(blit::packed_image) > metaLen)
+        return true;
+
+    auto icon = blit::Surface::load(buf.get() + ptr);
+    if(!icon)
+        return true;
+
+    if(icon->bounds.w <= max_icon_size && icon->bounds.h <= max_icon_size) {
+        entry.icon_w = icon->bounds.w;
+        entry.icon_h = icon->bounds.h;
+        entry.icon.resize(icon->bounds.area());
+
+        for(int i = 0; i < icon->bounds.area(); i++) {
+            if(icon->format == blit::PixelFormat::P)
+                entry.icon[i] = icon->palette[icon->data[i]];
+            else if(icon->format == blit::PixelFormat::RGBA)
+                entry.icon[i] = reinterpret_cast<blit::Pen *>(icon->data)[i];
+            else // RGB
+                entry.icon[i] = blit::Pen(icon->data[i * 3], icon->data[i * 3 + 1], icon->data[i * 3 + 2]);
+        }
+    }
+
+    delete[] icon->data;
+    delete[] icon->palette;
+    delete icon;
+
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "engine/file.hpp"
+#include "graphics/surface.hpp"
+
+// Metadata for every .blit file we've seen, saved between runs so the
+// listing doesn't need to open every file to show titles/icons.
+
+// finds the game binary in a .blit, after any relocation data
+bool read_game_header(blit::File &file, uint32_t &binOffset, uint32_t &binSize);
+
+struct CatalogEntry {
+    uint32_t size = 0;
+    bool has_metadata = false; // false if it couldn't be parsed, so we don't keep trying
+
+    char title[25] = "";
+    char author[17] = "";
+    char version[17] = "";
+    char category[17] = "";
+
+    uint8_t icon_w = 0, icon_h = 0;
+    std::vector<blit::Pen> icon; // decoded to RGBA
+};
+
+class GameCatalog final {
+public:
+    GameCatalog(std::string filename);
+
+    bool load();
+    bool save();
+
+    bool is_dirty() const {return dirty;}
+
+    const CatalogEntry *find(const std::string &path) const;
+
+    // parses the file if it's new or the size changed
+    const CatalogEntry *update(const std::string &path, uint32_t size);
+
+    // drop entries for files in dir (not subdirs) that don't exist any more
+    void remove_missing(const std::string &dir, std::function<bool(const std::string &name)> exists);
+
+private:
+    static bool parse_file(const std::string &path, CatalogEntry &entry);
+
+    std::string filename;
+    std::map<std::string, CatalogEntry> entries;
+    bool dirty = false;
+};
@@ -0,0 +1,44 @@
+#include <cctype>
+
+#include "ext-matcher.hpp"
+
+void ExtensionMatcher::set_extensions(const std::set<std::string> &exts) {
+    this->exts.clear();
+    chars.clear();
+
+    for(auto &ext : exts) {
+        if(ext.empty())
+            continue;
+
+        uint32_t offset = chars.size();
+
+        for(auto c : ext)
+            chars.push_back(tolower(c));
+
+        this->exts.push_back({offset, uint32_t(ext.length()), chars.back()});
+    }
+}
+
+bool ExtensionMatcher::match(const std::string &name) const {
+    if(name.empty())
+        return false;
+
+    char last = tolower(name.back());
+
+    for(auto &ext : exts) {
+        if(ext.length > name.length() || ext.last != last)
+            continue;
+
+        auto namePtr = name.data() + name.length() - ext.length;
+        auto extPtr = chars.data() + ext.offset;
+
+        uint32_t i = 0;
+        while(i < ext.length - 1 && tolower(namePtr[i]) == extPtr[i])
+            i++;
+
+        if(i == ext.length - 1)
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+// Case-insensitive check of the end of a file name against a list of extensions
+// (".blit", ".tar.gz"...) without allocating anything per name.
+
+class ExtensionMatcher final {
+public:
+    void set_extensions(const std::set<std::string> &exts);
+
+    bool empty() const {return exts.empty();}
+
+    bool match(const std::string &name) const;
+
+private:
+    struct Extension {
+        uint32_t offset, length;
+        char last; // quick reject before comparing the rest
+    };
+
+    std::vector<Extension> exts;
+    std::vector<char> chars; // lower case, back to back
+};
@@ -1,7 +1,115 @@
+#include <algorithm>
+#include <cstring>
+
 #include "file-browser.hpp"
 
 #include "engine/engine.hpp"
 
+static const char search_chars[] = "abcdefghijklmnopqrstuvwxyz0123456789 -_.";
+static const int num_search_chars = sizeof(search_chars) - 1;
+
+static const unsigned int max_recent_files = 32;
+
+static const char *sort_mode_names[]{"Name", "Size", "Recent"};
+
+// lower case with runs of digits replaced by '0', the number of digits and the digits
+// so that a plain compare orders numbers by value
+static void append_sort_key(std::vector<char> &out, const std::string &name) {
+    for(size_t i = 0; i < name.length();) {
+        if(!isdigit(name[i])) {
+            out.push_back(tolower(name[i++]));
+            continue;
+        }
+
+        // skip leading zeros, but keep one for 0
+        while(name[i] == '0' && i + 1 < name.length() && isdigit(name[i + 1]))
+            i++;
+
+        auto end = i;
+        while(end < name.length() && isdigit(name[end]))
+            end++;
+
+        out.push_back('0');
+        out.push_back(char(std::min(end - i, size_t(255))));
+        out.insert(out.end(), name.begin() + i, name.begin() + end);
+        i = end;
+    }
+
+    out.push_back(0);
+}
+
+void FileBrowser::Listing::add(const std::string &name, uint32_t size, uint32_t flags, uint16_t recent) {
+    uint32_t offset = names.size();
+
+    names.insert(names.end(), name.begin(), name.end());
+    if(flags & blit::FileFlags::directory)
+        names.push_back('/');
+    names.push_back(0);
+
+    uint32_t keyOffset = names.size();
+    append_sort_key(names, name);
+
+    files.push_back({offset, keyOffset, size, uint16_t(flags), recent});
+}
+
+void FileBrowser::Listing::clear() {
+    files.clear();
+    names.clear();
+}
+
+bool FileBrowser::Listing::compare(const FileEntry &a, const FileEntry &b) const {
+    if((a.flags ^ b.flags) & all_games_flag)
+        return a.flags & all_games_flag;
+
+    bool aDir = a.flags & blit::FileFlags::directory;
+    bool bDir = b.flags & blit::FileFlags::directory;
+
+    if(aDir != bDir)
+        return aDir;
+
+    if(sort_mode == SortMode::Size && a.size != b.size)
+        return a.size > b.size;
+
+    if(sort_mode == SortMode::Recent && a.recent != b.recent)
+        return a.recent < b.recent;
+
+    int res = strcmp(names.data() + a.key_offset, names.data() + b.key_offset);
+    if(res != 0)
+        return res < 0;
+
+    // only differ by case/leading zeros
+    return strcmp(get_name(a), get_name(b)) < 0;
+}
+
+void FileBrowser::Listing::sort(unsigned int first) {
+    auto compare = [this](const FileEntry &a, const FileEntry &b) {
+        return this->compare(a, b);
+    };
+
+    std::sort(files.begin() + first, files.end(), compare);
+    std::inplace_merge(files.begin(), files.begin() + first, files.end(), compare);
+}
+
+int FileBrowser::Listing::find(const FileEntry &entry) const {
+    auto it = std::lower_bound(files.begin(), files.end(), entry, [this](const FileEntry &a, const FileEntry &b) {
+        return compare(a, b);
+    });
+
+    if(it == files.end() || it->name_offset != entry.name_offset)
+        return -1;
+
+    return it - files.begin();
+}
+
+int FileBrowser::Listing::find(const char *name) const {
+    for(unsigned int i = 0; i < files.size(); i++) {
+        if(strcmp(get_name(files[i]), name) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
 FileBrowser::FileBrowser(const blit::Font &font) : Menu("", nullptr, 0, font) {
     // too early
     //files = blit::list_files("");
@@ -24,6 +132,19 @@ void FileBrowser::init() {
 
 void FileBrowser::render()
 {
+    // the scan may have added entries since the last update
+    update_window();
+
+    if(cur_dir.empty() && !searching) {
+        char buf[50];
+        if(game_index && game_index->is_scanning())
+            snprintf(buf, sizeof(buf), "All games (%i, scanning %i dirs...)", int(listing.files.size()), int(game_index->get_num_dirs_scanned()));
+        else
+            snprintf(buf, sizeof(buf), "All games (%i)", int(listing.files.size()));
+
+        title = buf;
+    }
+
     blit::Menu::render();
 
     const int iconSize = font.char_h > 8 ? 12 : 8;
@@ -37,68 +158,571 @@ void FileBrowser::render()
     r.x += item_padding_x;
     r.w -= item_padding_x * 2;
 
+    auto sortText = sort_mode_names[int(sort_mode)];
+
+    if(searching) {
+        char buf[40];
+        snprintf(buf, sizeof(buf), "%i found %ius", int(search.get_results().size()), int(search.get_last_time_us()));
+        blit::screen.text(buf, font, r, true, blit::TextAlign::center_right);
+    }
     // back icon
-    if(!cur_dir.empty()) {
+    else if(cur_dir != "/") {
         blit::Point iconOffset(-(backTextWidth + iconSize + 2), 1); // from the top-right
 
         blit::screen.text("Back", font, r, true, blit::TextAlign::center_right);
+        r.w -= backTextWidth + 8;
         //controlIcons.render(ControlIcons::Icon::B, r.tr() + iconOffset, header_foreground, iconSize);
     }
+
+    if(!searching)
+        blit::screen.text(sortText, font, r, true, blit::TextAlign::center_right);
+
+    // scan progress along the bottom of the header
+    if(scanning && !pending_files.empty()) {
+        int w = display_rect.w * scan_pos / pending_files.size();
+
+        blit::screen.pen = foreground_colour;
+        blit::screen.rectangle({display_rect.x, display_rect.y + header_h - 2, w, 2});
+    }
+}
+
+void FileBrowser::update(uint32_t time) {
+    if(scanning)
+        update_scan();
+
+    // show the new index if we're looking at it
+    if(game_index && game_index->update()) {
+        if(cur_dir.empty())
+            refresh();
+        else
+            dir_cache.erase("");
+    }
+
+    if(blit::buttons.pressed & blit::Button::Y) {
+        if(searching)
+            end_search();
+        else
+            start_search();
+    }
+
+    int count = get_num_entries();
+
+    if(count) {
+        if(blit::buttons.pressed & blit::Button::DPAD_UP)
+            selected = selected == 0 ? count - 1 : selected - 1;
+        else if(blit::buttons.pressed & blit::Button::DPAD_DOWN)
+            selected = (selected + 1) % count;
+    }
+
+    update_window();
+
+    if(searching) {
+        update_search();
+        return;
+    }
+
+    // LEFT/RIGHT to change sorting
+    if(blit::buttons.pressed & blit::Button::DPAD_LEFT)
+        set_sort_mode(SortMode((int(sort_mode) + num_sort_modes - 1) % num_sort_modes));
+    else if(blit::buttons.pressed & blit::Button::DPAD_RIGHT)
+        set_sort_mode(SortMode((int(sort_mode) + 1) % num_sort_modes));
+
+    if(!num_items)
+        return;
+
+    update_item(window_items[current_item]);
+
+    // may have changed directory
+    update_window();
+
+    if(num_items && (blit::buttons.released & blit::Button::A))
+        item_activated(window_items[current_item]);
 }
 
 void FileBrowser::set_extensions(std::set<std::string> exts) {
-    file_exts = exts;
+    file_exts.set_extensions(exts);
+
+    // cached listings were filtered with the old set
+    dir_cache.clear();
 }
 
 void FileBrowser::set_on_file_open(void (*func)(std::string)) {
     on_file_open = func;
 }
 
-void FileBrowser::update_list() {
-    title = cur_dir;
+void FileBrowser::set_sort_mode(SortMode mode) {
+    if(mode == sort_mode)
+        return;
+
+    sort_mode = mode;
+
+    // re-sort, staying on the same file (keys don't need recalculating)
+    int entry = selected < get_num_entries() ? get_entry(selected) : -1;
+    FileEntry selectedEntry = entry >= 0 ? listing.files[entry] : FileEntry{};
+
+    listing.sort_mode = mode;
+    listing.sort();
 
-    files = blit::list_files(cur_dir.substr(0, cur_dir.length() - 1));
+    if(entry >= 0 && !searching)
+        selected = std::max(0, listing.find(selectedEntry));
 
-    std::sort(files.begin(), files.end(), [](blit::FileInfo &a, blit::FileInfo & b){return a.name < b.name;});
+    // result indices are into the listing
+    if(searching)
+        update_search_index();
+}
+
+void FileBrowser::set_recent_file(std::string filename) {
+    recent_filename = filename;
+    recent_files.clear();
 
-    if(file_exts.empty())
+    blit::File file(filename);
+    if(!file.is_open())
         return;
 
-    // filter by extensions
-    files.erase(std::remove_if(files.begin(), files.end(), [this](const blit::FileInfo &f) {
-        if(!(f.flags & blit::FileFlags::directory)) {
-            std::string ext;
-            auto dotPos = f.name.find_last_of('.');
-            if(dotPos != std::string::npos)
-                ext = f.name.substr(dotPos);
+    std::string data(file.get_length(), 0);
+    file.read(0, data.length(), data.data());
+
+    size_t pos = 0;
+    while(pos < data.length() && recent_files.size() < max_recent_files) {
+        auto end = data.find('\n', pos);
+        if(end == std::string::npos)
+            end = data.length();
+
+        if(end > pos)
+            recent_files.push_back(data.substr(pos, end - pos));
+
+        pos = end + 1;
+    }
+
+    update_recent_in_dir();
+}
+
+std::string FileBrowser::get_selected_path() const {
+    if(selected >= get_num_entries())
+        return "";
+
+    auto &file = listing.files[get_entry(selected)];
+
+    if(file.flags & blit::FileFlags::directory)
+        return "";
+
+    return cur_dir + listing.get_name(file);
+}
+
+void FileBrowser::set_catalog(GameCatalog *catalog) {
+    this->catalog = catalog;
+}
 
-            // convert to lower case
-            std::for_each(ext.begin(), ext.end(), [](char & c) {c = tolower(c);});
+void FileBrowser::set_game_index(GameIndex *index) {
+    game_index = index;
 
-            if(file_exts.find(ext) == file_exts.end())
-                return true;
+    game_index->set_filter([this](const blit::FileInfo &file) {return filter_file(file);});
+
+    // nothing saved, go looking
+    if(!game_index->load())
+        game_index->start_scan();
+}
+
+void FileBrowser::refresh() {
+    // already getting a fresh listing
+    if(scanning)
+        return;
+
+    Listing newListing;
+
+    if(cur_dir.empty())
+        read_game_index(newListing);
+    else
+        read_dir(newListing);
+
+    // nothing changed, keep the existing listing
+    bool same = newListing.files.size() == listing.files.size() && newListing.names == listing.names
+        && std::equal(newListing.files.begin(), newListing.files.end(), listing.files.begin(),
+        [](const FileEntry &a, const FileEntry &b) {
+            return a.size == b.size && a.flags == b.flags;
         }
+    );
 
-        return false;
-    }), files.end());
+    if(same)
+        return;
 
-    // update menu items
-    file_items.resize(files.size());
+    std::string selectedName;
+    if(selected < int(listing.files.size()))
+        selectedName = listing.get_name(selected);
 
-    unsigned int i = 0;
-    for(auto &file : files) {
-        if(file.flags & blit::FileFlags::directory)
-            file.name += "/";
+    listing = std::move(newListing);
+    update_catalog();
 
-        file_items[i].id = i;
-        file_items[i++].label = file.name.c_str();
+    if(searching) {
+        update_search_index();
+        return;
     }
 
-    set_items(file_items.data(), file_items.size());
+    // try to stay on the same file
+    selected = std::max(0, listing.find(selectedName.c_str()));
+}
+
+void FileBrowser::invalidate(const std::string &dir) {
+    if(dir == cur_dir)
+        refresh();
+    else
+        dir_cache.erase(dir);
+}
+
+void FileBrowser::invalidate_all() {
+    dir_cache.clear();
+    refresh();
+}
+
+void FileBrowser::change_dir(std::string dir) {
+    // stash the current listing (unless it's only partially read)
+    if(!scanning) {
+        auto &cached = dir_cache[cur_dir];
+        cached.listing = std::move(listing);
+        cached.selected = selected;
+        cached.last_used = ++cache_counter;
+    }
+
+    scanning = false;
+    searching = false;
+
+    cur_dir = dir;
+    window_start = 0;
+
+    update_recent_in_dir();
+
+    auto it = dir_cache.find(cur_dir);
+
+    if(it == dir_cache.end())
+        update_list();
+    else {
+        listing = std::move(it->second.listing);
+        selected = it->second.selected;
+        dir_cache.erase(it);
+
+        title = cur_dir;
+
+        // sorting was changed after leaving
+        if(listing.sort_mode != sort_mode) {
+            FileEntry selectedEntry = listing.files.empty() ? FileEntry{} : listing.files[std::min(selected, int(listing.files.size()) - 1)];
+
+            listing.sort_mode = sort_mode;
+            listing.sort();
+
+            if(!listing.files.empty())
+                selected = std::max(0, listing.find(selectedEntry));
+        }
+    }
+
+    // drop the least recently used
+    while(dir_cache.size() > max_cached_dirs) {
+        auto oldest = std::min_element(dir_cache.begin(), dir_cache.end(), [](auto &a, auto &b) {
+            return a.second.last_used < b.second.last_used;
+        });
+        dir_cache.erase(oldest);
+    }
+}
+
+bool FileBrowser::filter_file(const blit::FileInfo &file) const {
+    if(file_exts.empty() || (file.flags & blit::FileFlags::directory))
+        return true;
+
+    return file_exts.match(file.name);
+}
+
+void FileBrowser::update_recent_in_dir() {
+    recent_in_dir.clear();
+
+    for(unsigned int i = 0; i < recent_files.size(); i++) {
+        auto &path = recent_files[i];
+
+        // names are full paths in "All games"
+        if(cur_dir.empty())
+            recent_in_dir.emplace_back(path, i);
+        else if(path.length() > cur_dir.length() && path.compare(0, cur_dir.length(), cur_dir) == 0
+        && path.find('/', cur_dir.length()) == std::string::npos)
+            recent_in_dir.emplace_back(path.substr(cur_dir.length()), i);
+    }
+}
+
+uint16_t FileBrowser::get_recent(const std::string &name) const {
+    for(auto &recent : recent_in_dir) {
+        if(recent.first == name)
+            return recent.second;
+    }
+
+    return not_recent;
+}
+
+void FileBrowser::add_recent(const std::string &path) {
+    if(recent_filename.empty())
+        return;
+
+    auto it = std::find(recent_files.begin(), recent_files.end(), path);
+    if(it != recent_files.end())
+        recent_files.erase(it);
+
+    recent_files.insert(recent_files.begin(), path);
+
+    if(recent_files.size() > max_recent_files)
+        recent_files.pop_back();
+
+    std::string data;
+    for(auto &file : recent_files)
+        data += file + "\n";
+
+    blit::File file(recent_filename, blit::OpenMode::write);
+    file.write(0, data.length(), data.c_str());
+}
+
+void FileBrowser::read_dir(Listing &out) {
+    out.clear();
+    out.sort_mode = sort_mode;
+
+    for(auto &file : blit::list_files(cur_dir.substr(0, cur_dir.length() - 1))) {
+        if(filter_file(file))
+            out.add(file.name, file.size, file.flags, get_recent(file.name));
+    }
+
+    add_virtual_entries(out);
+
+    out.sort();
+}
+
+void FileBrowser::add_virtual_entries(Listing &out) {
+    if(cur_dir == "/" && game_index)
+        out.add("All games", 0, blit::FileFlags::directory | all_games_flag, not_recent);
+}
+
+void FileBrowser::read_game_index(Listing &out) {
+    out.clear();
+    out.sort_mode = sort_mode;
+
+    for(auto &entry : game_index->get_entries())
+        out.add(entry.path, entry.size, 0, get_recent(entry.path));
+
+    out.sort();
+}
+
+void FileBrowser::start_scan() {
+    pending_files = blit::list_files(cur_dir.substr(0, cur_dir.length() - 1));
+    scan_pos = 0;
+    scanning = true;
+
+    listing.clear();
+    listing.sort_mode = sort_mode;
+    selected = 0;
+
+    add_virtual_entries(listing);
+
+    update_scan();
+}
+
+void FileBrowser::update_scan() {
+    auto start = blit::now_us();
+
+    // filter as much as fits in the slice
+    unsigned int firstNew = listing.files.size();
+
+    while(scan_pos < pending_files.size() && blit::us_diff(start, blit::now_us()) < scan_slice_us) {
+        auto &file = pending_files[scan_pos++];
+
+        if(!filter_file(file))
+            continue;
+
+        // parsing new files counts towards the slice
+        if(catalog && !(file.flags & blit::FileFlags::directory))
+            catalog->update(cur_dir + file.name, file.size);
+
+        listing.add(file.name, file.size, file.flags, get_recent(file.name));
+    }
+
+    // sort the new chunk and merge it in, keeping the selection on the same file
+    if(listing.files.size() != firstNew) {
+        bool hadSelection = selected < int(firstNew);
+        FileEntry selectedEntry = hadSelection ? listing.files[selected] : FileEntry{};
+
+        listing.sort(firstNew);
+
+        if(searching)
+            update_search_index();
+        else if(hadSelection)
+            selected = std::max(0, listing.find(selectedEntry));
+    }
+
+    if(scan_pos == pending_files.size()) {
+        scanning = false;
+        pending_files.clear();
+        pending_files.shrink_to_fit();
+
+        update_catalog();
+    }
+}
+
+void FileBrowser::update_window() {
+    int count = get_num_entries();
+    int rows = (display_rect.h - header_h - footer_h - margin_y * 2) / item_h;
+    rows = std::max(1, std::min(rows, max_visible_items));
+
+    selected = std::max(0, std::min(selected, count - 1));
+
+    // scroll just enough to keep the selection visible
+    if(selected < window_start)
+        window_start = selected;
+    else if(selected >= window_start + rows)
+        window_start = selected - rows + 1;
+
+    window_start = std::max(0, std::min(window_start, count - rows));
+
+    int numVisible = std::min(rows, count - window_start);
+
+    for(int i = 0; i < numVisible; i++) {
+        int entry = get_entry(window_start + i);
+        window_items[i].id = entry;
+        window_items[i].label = listing.get_name(entry);
+    }
+
+    set_items(window_items, numVisible);
+    current_item = selected - window_start;
+}
+
+int FileBrowser::get_num_entries() const {
+    return searching ? search.get_results().size() : listing.files.size();
+}
+
+int FileBrowser::get_entry(int row) const {
+    return searching ? search.get_results()[row] : row;
+}
+
+void FileBrowser::start_search() {
+    searching = true;
+    search_query.clear();
+
+    update_search_index();
+    update_search_title();
+}
+
+void FileBrowser::end_search() {
+    // stay on the result that was selected
+    if(selected < get_num_entries())
+        selected = get_entry(selected);
+
+    searching = false;
+    title = cur_dir;
+}
+
+void FileBrowser::update_search() {
+    bool changed = false;
+
+    if(blit::buttons.pressed & blit::Button::DPAD_LEFT)
+        search_char = search_char == 0 ? num_search_chars - 1 : search_char - 1;
+    else if(blit::buttons.pressed & blit::Button::DPAD_RIGHT)
+        search_char = (search_char + 1) % num_search_chars;
+
+    if(blit::buttons.pressed & blit::Button::A) {
+        search_query += search_chars[search_char];
+        changed = true;
+    }
+    else if(blit::buttons.pressed & blit::Button::B) {
+        if(search_query.empty()) {
+            end_search();
+            return;
+        }
+
+        search_query.pop_back();
+        changed = true;
+    }
+    else if((blit::buttons.pressed & blit::Button::X) && num_items) {
+        // open the result
+        auto item = window_items[current_item];
+        end_search();
+        update_window();
+        item_activated(item);
+        return;
+    }
+
+    if(changed) {
+        search.set_query(search_query);
+        selected = window_start = 0;
+    }
+
+    update_search_title();
+}
+
+void FileBrowser::update_search_index() {
+    search.build(listing.files.size(), [this](int index) {return listing.get_name(index);});
+    search.set_query(search_query);
+    selected = window_start = 0;
+}
+
+void FileBrowser::update_search_title() {
+    title = "Search: " + search_query + "[" + search_chars[search_char] + "]";
+}
+
+void FileBrowser::update_catalog() {
+    // entries for "All games" come from all over, only show what's already there
+    if(!catalog || cur_dir.empty())
+        return;
+
+    // scanning already did this
+    if(!scanning) {
+        for(auto &file : listing.files) {
+            if(!(file.flags & blit::FileFlags::directory))
+                catalog->update(cur_dir + listing.get_name(file), file.size);
+        }
+    }
+
+    // sorted names to search, the listing might not be sorted by name
+    std::vector<const char *> sortedNames;
+    sortedNames.reserve(listing.files.size());
+
+    for(auto &file : listing.files)
+        sortedNames.push_back(listing.get_name(file));
+
+    std::sort(sortedNames.begin(), sortedNames.end(), [](const char *a, const char *b) {return strcmp(a, b) < 0;});
+
+    catalog->remove_missing(cur_dir, [&sortedNames](const std::string &name) {
+        return std::binary_search(sortedNames.begin(), sortedNames.end(), name.c_str(), [](const char *a, const char *b) {return strcmp(a, b) < 0;});
+    });
+
+    if(catalog->is_dirty())
+        catalog->save();
+}
+
+void FileBrowser::update_list() {
+    title = cur_dir;
+
+    if(cur_dir.empty()) {
+        read_game_index(listing);
+        selected = 0;
+    } else
+        start_scan();
 }
 
 void FileBrowser::render_item(const Item &item, int y, int index) const {
-    blit::Menu::render_item(item, y, index);
+    // item ids are the index in the whole listing
+    auto entry = catalog ? catalog->find(cur_dir + listing.get_name(item.id)) : nullptr;
+
+    if(entry && entry->has_metadata) {
+        blit::Rect r(display_rect.x + item_padding_x, y, display_rect.w - item_padding_x * 2, item_h);
+
+        // icon squashed to fit the row
+        if(!entry->icon.empty()) {
+            blit::Surface icon(const_cast<uint8_t *>(reinterpret_cast<const uint8_t *>(entry->icon.data())), blit::PixelFormat::RGBA, blit::Size(entry->icon_w, entry->icon_h));
+            blit::screen.stretch_blit(&icon, blit::Rect(0, 0, entry->icon_w, entry->icon_h), blit::Rect(r.x, y + 1, item_h - 2, item_h - 2));
+        }
+
+        r.x += item_h;
+        r.w -= item_h;
+
+        blit::screen.pen = foreground_colour;
+        blit::screen.text(entry->title, font, r, true, blit::TextAlign::center_left);
+
+        blit::screen.pen = blit::Pen(0x88, 0x88, 0x88);
+        blit::screen.text(entry->version, font, r, true, blit::TextAlign::center_right);
+    }
+    else
+        blit::Menu::render_item(item, y, index);
 
     if(index == current_item) {
         const int iconSize = font.char_h > 8 ? 12 : 8;
@@ -111,27 +735,40 @@ void FileBrowser::render_item(const Item &item, int y, int index) const {
 
 void FileBrowser::update_item(const Item &item) {
     if(blit::buttons.released & blit::Button::B) {
-        if(cur_dir != "/") {
+        if(cur_dir.empty())
+            change_dir("/");
+        else if(cur_dir != "/") {
             // go up
             auto pos = cur_dir.find_last_of('/', cur_dir.length() - 2);
             if(pos == std::string::npos)
-                cur_dir = "";
+                change_dir("");
             else
-                cur_dir = cur_dir.substr(0, pos + 1);
-
-            update_list();
+                change_dir(cur_dir.substr(0, pos + 1));
         }
     }
+    else if(blit::buttons.released & blit::Button::X) {
+        // "refreshing" all games rescans everything
+        if(cur_dir.empty() && game_index)
+            game_index->start_scan();
+        else
+            refresh();
+    }
 }
 
 void FileBrowser::item_activated(const Item &item){
     if(!num_items)
         return;
 
-    if(files[current_item].flags & blit::FileFlags::directory) {
-        cur_dir += files[current_item].name;
-        update_list();
+    auto &file = listing.files[item.id];
+
+    if(file.flags & all_games_flag)
+        change_dir("");
+    else if(file.flags & blit::FileFlags::directory) {
+        change_dir(cur_dir + listing.get_name(file));
+    }
+    else if(on_file_open) {
+        auto path = cur_dir + listing.get_name(file);
+        add_recent(path);
+        on_file_open(path);
     }
-    else if(on_file_open)
-        on_file_open(cur_dir + files[current_item].name);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -8,19 +9,134 @@
 #include "engine/file.hpp"
 #include "engine/menu.hpp"
 
+#include "catalog.hpp"
+#include "ext-matcher.hpp"
+#include "fuzzy-search.hpp"
+#include "game-index.hpp"
+
 class FileBrowser final : public blit::Menu {
 public:
+    // directories always come first, names are compared case-insensitively with numbers by value
+    enum class SortMode {
+        Name = 0,
+        Size, // largest first
+        Recent, // most recently opened first
+    };
+
+    static const int num_sort_modes = int(SortMode::Recent) + 1;
+
     FileBrowser(const blit::Font &font = blit::minimal_font);
 
     void init();
 
     void render();
 
+    // hides Menu::update, handles navigation over the whole listing
+    void update(uint32_t time);
+
     void set_extensions(std::set<std::string> exts);
 
     void set_on_file_open(void (*func)(std::string));
 
+    void set_sort_mode(SortMode mode);
+
+    // remember opened files in this file for SortMode::Recent
+    void set_recent_file(std::string filename);
+
+    // full path of the highlighted file, empty if it's a directory
+    std::string get_selected_path() const;
+
+    // show titles/icons from the catalog, updating it as directories are read
+    void set_catalog(GameCatalog *catalog);
+
+    // adds an "All games" directory at the root listing everything in the index
+    void set_game_index(GameIndex *index);
+
+    // re-read the current directory, keeping the selection if it still exists
+    void refresh();
+
+    // drop a cached listing after changing the directory's contents
+    void invalidate(const std::string &dir);
+    void invalidate_all();
+
 private:
+    struct FileEntry {
+        uint32_t name_offset;
+        uint32_t key_offset;
+        uint32_t size;
+        uint16_t flags;
+        uint16_t recent; // position in the recent list
+    };
+
+    static const uint16_t not_recent = 0xFFFF;
+
+    static const uint16_t all_games_flag = 0x8000; // the virtual directory, cur_dir is "" inside it
+
+    // entries with their names and sort keys packed into one buffer (directories have a trailing /)
+    struct Listing {
+        std::vector<FileEntry> files;
+        std::vector<char> names;
+        SortMode sort_mode = SortMode::Name;
+
+        const char *get_name(const FileEntry &entry) const {return names.data() + entry.name_offset;}
+        const char *get_name(int index) const {return get_name(files[index]);}
+
+        void add(const std::string &name, uint32_t size, uint32_t flags, uint16_t recent);
+        void clear();
+
+        bool compare(const FileEntry &a, const FileEntry &b) const;
+
+        // sort everything from first on and merge it into the already sorted entries before it
+        void sort(unsigned int first = 0);
+
+        // find where an entry from before a sort ended up
+        int find(const FileEntry &entry) const;
+        int find(const char *name) const;
+    };
+
+    // listings for directories we've left, so going back doesn't re-read them
+    struct CachedDir {
+        Listing listing;
+        int selected;
+        uint32_t last_used;
+    };
+
+    static const unsigned int max_cached_dirs = 16;
+
+    // only the rows on screen get menu items
+    static const int max_visible_items = 64;
+
+    static const uint32_t scan_slice_us = 2000; // per update
+
+    void change_dir(std::string dir);
+
+    bool filter_file(const blit::FileInfo &file) const;
+
+    void update_recent_in_dir();
+    uint16_t get_recent(const std::string &name) const;
+    void add_recent(const std::string &path);
+
+    void read_dir(Listing &out);
+
+    void add_virtual_entries(Listing &out);
+    void read_game_index(Listing &out);
+
+    void start_scan();
+    void update_scan();
+
+    void update_window();
+
+    int get_num_entries() const;
+    int get_entry(int row) const;
+
+    void start_search();
+    void end_search();
+    void update_search();
+    void update_search_index();
+    void update_search_title();
+
+    void update_catalog();
+
     void update_list();
 
     void render_item(const Item &item, int y, int index) const override;
@@ -29,10 +145,37 @@ private:
 
     void item_activated(const Item &item) override;
 
-    std::vector<blit::FileInfo> files;
-    std::vector<Item> file_items;
+    Listing listing;
+    int selected = 0;
     std::string cur_dir = "/";
 
-    std::set<std::string> file_exts;
+    int window_start = 0;
+    Item window_items[max_visible_items];
+
+    std::map<std::string, CachedDir> dir_cache;
+    uint32_t cache_counter = 0;
+
+    // incremental scan, everything from pending_files before scan_pos has been added to the listing
+    bool scanning = false;
+    std::vector<blit::FileInfo> pending_files;
+    unsigned int scan_pos = 0;
+
+    ExtensionMatcher file_exts;
     void (*on_file_open)(std::string) = nullptr;
+
+    GameCatalog *catalog = nullptr;
+
+    GameIndex *game_index = nullptr;
+
+    SortMode sort_mode = SortMode::Name;
+
+    std::string recent_filename;
+    std::vector<std::string> recent_files; // full paths, most recent first
+    std::vector<std::pair<std::string, uint16_t>> recent_in_dir; // names in cur_dir
+
+    // type-to-search, selected/window_start are in the results when searching
+    bool searching = false;
+    FuzzySearch search;
+    std::string search_query;
+    int search_char = 0;
 };
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "filter-benchmark.hpp"
+#include "ext-matcher.hpp"
+
+#include "engine/engine.hpp"
+
+static const int num_names = 1000;
+static const int num_runs = 10;
+
+// what FileBrowser used to do
+static bool old_filter(const std::string &name, const std::set<std::string> &exts) {
+    std::string ext;
+    auto dotPos = name.find_last_of('.');
+    if(dotPos != std::string::npos)
+        ext = name.substr(dotPos);
+
+    // convert to lower case
+    std::for_each(ext.begin(), ext.end(), [](char & c) {c = tolower(c);});
+
+    return exts.find(ext) != exts.end();
+}
+
+std::string run_filter_benchmark() {
+    static const char *suffixes[]{".blit", ".BLIT", ".txt", ".tar.gz", ".bin", ""};
+
+    std::vector<std::string> names;
+    names.reserve(num_names);
+
+    for(int i = 0; i < num_names; i++)
+        names.push_back("some_game_" + std::to_string(i) + suffixes[i % 6]);
+
+    std::set<std::string> exts{".blit", ".bin"};
+
+    ExtensionMatcher matcher;
+    matcher.set_extensions(exts);
+
+    // the matches are counted so the work isn't optimised out
+    int oldMatches = 0, newMatches = 0;
+
+    auto start = blit::now_us();
+
+    for(int run = 0; run < num_runs; run++) {
+        for(auto &name : names)
+            oldMatches += old_filter(name, exts);
+    }
+
+    auto oldTime = blit::us_diff(start, blit::now_us()) / num_runs;
+
+    start = blit::now_us();
+
+    for(int run = 0; run < num_runs; run++) {
+        for(auto &name : names)
+            newMatches += matcher.match(name);
+    }
+
+    auto newTime = blit::us_diff(start, blit::now_us()) / num_runs;
+
+    char buf[100];
+    snprintf(buf, sizeof(buf), "Filter per %i: old %uus new %uus (%i/%i matched)", num_names,
+             unsigned(oldTime), unsigned(newTime), oldMatches / num_runs, newMatches / num_runs);
+
+    return buf;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <string>
+
+// Times the old substr/tolower/std::set extension filter against ExtensionMatcher
+// over the same generated file names, returns a line to show.
+
+std::string run_filter_benchmark();
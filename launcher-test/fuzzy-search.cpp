@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include "fuzzy-search.hpp"
+
+#include "engine/engine.hpp"
+
+void FuzzySearch::build(int count, NameFunc get_name) {
+    this->get_name = get_name;
+
+    masks.resize(count);
+
+    for(int i = 0; i < count; i++) {
+        uint64_t mask = 0;
+
+        for(auto name = get_name(i); *name; name++)
+            mask |= get_char_mask(*name);
+
+        masks[i] = mask;
+    }
+
+    // needs a new set_query
+    query.clear();
+    levels.clear();
+    results.clear();
+}
+
+void FuzzySearch::set_query(const std::string &newQuery) {
+    auto start = blit::now_us();
+
+    std::string lowerQuery = newQuery;
+    std::for_each(lowerQuery.begin(), lowerQuery.end(), [](char & c) {c = tolower(c);});
+
+    // keep the matches for the part that didn't change
+    unsigned int common = 0;
+    while(common < query.length() && common < lowerQuery.length() && query[common] == lowerQuery[common])
+        common++;
+
+    if(levels.empty()) {
+        // everything matches an empty query
+        levels.emplace_back();
+        levels[0].reserve(masks.size());
+
+        for(int i = 0; i < int(masks.size()); i++)
+            levels[0].push_back({i, 0});
+    }
+
+    levels.resize(common + 1);
+    query = lowerQuery;
+
+    // narrow down one character at a time
+    uint64_t queryMask = 0;
+    for(unsigned int i = 0; i < common; i++)
+        queryMask |= get_char_mask(query[i]);
+
+    for(unsigned int len = common + 1; len <= query.length(); len++) {
+        queryMask |= get_char_mask(query[len - 1]);
+
+        auto prefix = query.substr(0, len);
+        std::vector<Match> matches;
+
+        for(auto &prev : levels[len - 1]) {
+            if((masks[prev.index] & queryMask) != queryMask)
+                continue;
+
+            int score = score_name(get_name(prev.index), prefix);
+            if(score >= 0)
+                matches.push_back({prev.index, score});
+        }
+
+        levels.push_back(std::move(matches));
+    }
+
+    // rank the final set
+    auto ranked = levels.back();
+    std::stable_sort(ranked.begin(), ranked.end(), [](const Match &a, const Match &b) {return a.score > b.score;});
+
+    results.resize(ranked.size());
+    for(unsigned int i = 0; i < ranked.size(); i++)
+        results[i] = ranked[i].index;
+
+    last_time_us = blit::us_diff(start, blit::now_us());
+}
+
+uint64_t FuzzySearch::get_char_mask(char c) {
+    return uint64_t(1) << (tolower(c) & 63);
+}
+
+int FuzzySearch::score_name(const char *name, const std::string &query) const {
+    if(query.empty())
+        return 0;
+
+    int score = 0;
+    int prev = -2;
+    unsigned int q = 0;
+
+    for(int i = 0; name[i] && q < query.length(); i++) {
+        if(tolower(name[i]) != query[q])
+            continue;
+
+        int charScore = 1;
+
+        // runs of characters and the start of words are worth more
+        if(i == prev + 1)
+            charScore += 4;
+
+        if(i == 0 || !isalnum(name[i - 1]))
+            charScore += 3;
+
+        score += charScore;
+        prev = i;
+        q++;
+    }
+
+    if(q < query.length())
+        return -1;
+
+    // prefer shorter names for the same matches
+    return score * 256 - std::min(int(strlen(name)), 255);
+}
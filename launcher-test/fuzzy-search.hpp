@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Subsequence matching over a list of names, ranked by how well they match.
+// Each name gets a mask of the characters it contains so most non-matches are
+// rejected without looking at the name. Adding a character only searches the
+// previous results and removing one goes back to them.
+
+class FuzzySearch final {
+public:
+    using NameFunc = std::function<const char *(int index)>;
+
+    // call set_query after this to get results
+    void build(int count, NameFunc get_name);
+
+    void set_query(const std::string &query);
+    const std::string &get_query() const {return query;}
+
+    // indices, best match first
+    const std::vector<int> &get_results() const {return results;}
+
+    uint32_t get_last_time_us() const {return last_time_us;}
+
+private:
+    struct Match {
+        int index;
+        int score;
+    };
+
+    static uint64_t get_char_mask(char c);
+
+    int score_name(const char *name, const std::string &query) const;
+
+    NameFunc get_name;
+    std::vector<uint64_t> masks;
+
+    std::string query; // lower case
+    std::vector<std::vector<Match>> levels; // matches for each query length
+    std::vector<int> results;
+
+    uint32_t last_time_us = 0;
+};
@@ -0,0 +1,117 @@
+#include <algorithm>
+
+#include "game-index.hpp"
+
+#include "engine/engine.hpp"
+
+GameIndex::GameIndex(std::string filename) : filename(filename) {
+}
+
+void GameIndex::set_filter(std::function<bool(const blit::FileInfo &)> filter) {
+    this->filter = filter;
+}
+
+bool GameIndex::load() {
+    blit::File file(filename);
+
+    if(!file.is_open())
+        return false;
+
+    std::string data(file.get_length(), 0);
+    if(file.read(0, data.length(), data.data()) != int32_t(data.length()))
+        return false;
+
+    entries.clear();
+
+    // size,path per line
+    size_t pos = 0;
+    while(pos < data.length()) {
+        auto end = data.find('\n', pos);
+        if(end == std::string::npos)
+            end = data.length();
+
+        auto comma = data.find(',', pos);
+
+        if(comma < end)
+            entries.push_back({data.substr(comma + 1, end - comma - 1), uint32_t(strtoul(data.c_str() + pos, nullptr, 10))});
+
+        pos = end + 1;
+    }
+
+    return true;
+}
+
+bool GameIndex::save() {
+    std::string data;
+
+    for(auto &entry : entries)
+        data += std::to_string(entry.size) + "," + entry.path + "\n";
+
+    blit::File file(filename, blit::OpenMode::write);
+
+    return file.is_open() && file.write(0, data.length(), data.c_str()) == int32_t(data.length());
+}
+
+void GameIndex::start_scan() {
+    pending_dirs.clear();
+    pending_dirs.emplace_back("/", 0);
+
+    new_entries.clear();
+    seen.clear();
+    dirs_scanned = 0;
+
+    scanning = true;
+}
+
+bool GameIndex::update() {
+    if(!scanning)
+        return false;
+
+    auto start = blit::now_us();
+
+    // breadth first, so the shallowest copy of a file is the one we keep
+    while(!pending_dirs.empty() && new_entries.size() < max_entries && blit::us_diff(start, blit::now_us()) < scan_slice_us) {
+        auto [dir, depth] = pending_dirs.front();
+        pending_dirs.pop_front();
+
+        dirs_scanned++;
+
+        for(auto &file : blit::list_files(dir.substr(0, dir.length() - 1))) {
+            if(file.flags & blit::FileFlags::directory) {
+                // skip hidden/system dirs
+                if(depth + 1 < max_depth && file.name[0] != '.')
+                    pending_dirs.emplace_back(dir + file.name + "/", depth + 1);
+
+                continue;
+            }
+
+            if(filter && !filter(file))
+                continue;
+
+            auto key = file.name + ":" + std::to_string(file.size);
+            std::for_each(key.begin(), key.end(), [](char & c) {c = tolower(c);});
+
+            if(!seen.insert(key).second)
+                continue;
+
+            new_entries.push_back({dir + file.name, file.size});
+
+            if(new_entries.size() == max_entries)
+                break;
+        }
+    }
+
+    if(!pending_dirs.empty() && new_entries.size() < max_entries)
+        return false;
+
+    // done (or full)
+    scanning = false;
+    entries = std::move(new_entries);
+    new_entries.clear();
+    pending_dirs.clear();
+    seen.clear();
+
+    save();
+
+    return true;
+}
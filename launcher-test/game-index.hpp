@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "engine/file.hpp"
+
+// Every matching file on the card, found by walking the directory tree a few
+// directories per update. Saved so it only needs rescanning when asked.
+
+class GameIndex final {
+public:
+    struct Entry {
+        std::string path;
+        uint32_t size;
+    };
+
+    GameIndex(std::string filename);
+
+    // which files to include, directories are always searched
+    void set_filter(std::function<bool(const blit::FileInfo &)> filter);
+
+    bool load();
+    bool save();
+
+    void start_scan();
+
+    // returns true when a scan has just finished
+    bool update();
+
+    bool is_scanning() const {return scanning;}
+    unsigned int get_num_dirs_scanned() const {return dirs_scanned;}
+
+    // the previous results are kept until a scan finishes
+    const std::vector<Entry> &get_entries() const {return entries;}
+
+private:
+    static const int max_depth = 8;
+    static const unsigned int max_entries = 4096;
+    static const uint32_t scan_slice_us = 2000;
+
+    std::string filename;
+    std::function<bool(const blit::FileInfo &)> filter;
+
+    std::vector<Entry> entries;
+
+    bool scanning = false;
+    std::deque<std::pair<std::string, int>> pending_dirs; // with trailing /, depth
+    std::vector<Entry> new_entries;
+    std::set<std::string> seen; // name + size, so copies only show up once
+    unsigned int dirs_scanned = 0;
+};
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cstring>
+
+#include "launch-profiler.hpp"
+#include "catalog.hpp"
+
+#include "engine/api_private.hpp"
+#include "engine/engine.hpp"
+#include "graphics/font.hpp"
+#include "graphics/surface.hpp"
+
+static const uint32_t read_chunk_size = 4096;
+
+static uint32_t crc_table[256];
+
+static void init_crc_table() {
+    if(crc_table[1])
+        return;
+
+    for(uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for(int j = 0; j < 8; j++)
+            c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+
+        crc_table[i] = c;
+    }
+}
+
+static uint32_t update_crc(uint32_t crc, const uint8_t *data, uint32_t len) {
+    crc = ~crc;
+
+    for(uint32_t i = 0; i < len; i++)
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+bool LaunchProfiler::Verify::begin(const std::string &path) {
+    this->path = path;
+    timeline = Timeline();
+
+    auto start = blit::now_us();
+
+    file.close();
+
+    if(!file.open(path)) {
+        state = State::Failed;
+        return false;
+    }
+
+    timeline.size = file.get_length();
+
+    auto opened = blit::now_us();
+    timeline.open_us = blit::us_diff(start, opened);
+
+    uint32_t binSize;
+    if(!read_game_header(file, offset, binSize)) {
+        state = State::Failed;
+        return false;
+    }
+
+    end = offset + binSize;
+    crc = 0;
+
+    // the metadata has the CRC of the binary
+    char metaHeader[14];
+    has_crc = file.read(end, 14, metaHeader) == 14 && memcmp(metaHeader, "BLITMETA", 8) == 0;
+
+    if(has_crc)
+        memcpy(&expected_crc, metaHeader + 10, 4);
+
+    timeline.header_us = blit::us_diff(opened, blit::now_us());
+
+    state = State::Verifying;
+    init_crc_table();
+    return true;
+}
+
+void LaunchProfiler::Verify::step(uint32_t budget_us) {
+    static uint8_t buf[read_chunk_size];
+
+    auto start = blit::now_us();
+
+    while(offset < end && blit::us_diff(start, blit::now_us()) < budget_us) {
+        uint32_t len = std::min(read_chunk_size, end - offset);
+
+        if(file.read(offset, len, reinterpret_cast<char *>(buf)) != int32_t(len)) {
+            state = State::Failed;
+            break;
+        }
+
+        crc = update_crc(crc, buf, len);
+        offset += len;
+    }
+
+    timeline.verify_us += blit::us_diff(start, blit::now_us());
+
+    if(state == State::Verifying && offset >= end) {
+        if(has_crc)
+            timeline.crc = crc == expected_crc ? CRCResult::OK : CRCResult::Bad;
+
+        state = State::Done;
+        file.close();
+    }
+}
+
+void LaunchProfiler::set_history_file(std::string filename) {
+    history_filename = filename;
+    last_launch.clear();
+
+    blit::File file(filename);
+    if(!file.is_open())
+        return;
+
+    std::string data(file.get_length(), 0);
+    file.read(0, data.length(), data.data());
+
+    // keep the latest for each file
+    size_t pos = 0;
+    while(pos < data.length()) {
+        auto end = data.find('\n', pos);
+        if(end == std::string::npos)
+            end = data.length();
+
+        auto line = data.substr(pos, end - pos);
+        pos = end + 1;
+
+        // the path could have commas in it, count back from the end
+        auto comma = line.length();
+        for(int i = 0; i < 7 && comma != std::string::npos && comma > 0; i++)
+            comma = line.rfind(',', comma - 1);
+
+        if(comma == std::string::npos || comma == 0)
+            continue;
+
+        unsigned int size, prewarmed, open, header, verify, wait, crc;
+        if(sscanf(line.c_str() + comma + 1, "%u,%u,%u,%u,%u,%u,%u", &size, &prewarmed, &open, &header, &verify, &wait, &crc) != 7)
+            continue;
+
+        Timeline timeline;
+        timeline.size = size;
+        timeline.prewarmed = prewarmed != 0;
+        timeline.open_us = open;
+        timeline.header_us = header;
+        timeline.verify_us = verify;
+        timeline.wait_us = wait;
+        timeline.crc = CRCResult(crc);
+        last_launch[line.substr(0, comma)] = timeline;
+    }
+}
+
+void LaunchProfiler::hover(const std::string &path) {
+    if(path == prewarm.path)
+        return;
+
+    // moved, start again
+    prewarm.file.close();
+    prewarm.path = path;
+    prewarm.state = path.empty() ? State::Idle : State::Waiting;
+    hover_start = blit::now();
+    error.clear();
+}
+
+void LaunchProfiler::update() {
+    if(prewarm.state == State::Waiting && blit::now() - hover_start >= hover_delay)
+        prewarm.begin(prewarm.path);
+
+    if(prewarm.state == State::Verifying)
+        prewarm.step(prewarm_slice_us);
+}
+
+void LaunchProfiler::launch(const std::string &path) {
+    auto start = blit::now_us();
+
+    Timeline timeline;
+    State result;
+
+    if(prewarm.path == path && prewarm.state != State::Idle && prewarm.state != State::Waiting) {
+        // finish anything that's left
+        if(prewarm.state == State::Verifying)
+            prewarm.step(~0u);
+
+        result = prewarm.state;
+        timeline = prewarm.timeline;
+        timeline.prewarmed = true;
+    } else {
+        Verify verify;
+        if(verify.begin(path))
+            verify.step(~0u);
+
+        result = verify.state;
+        timeline = verify.timeline;
+    }
+
+    if(result == State::Failed) {
+        error = "Not a valid game!";
+        return;
+    }
+
+    timeline.wait_us = blit::us_diff(start, blit::now_us());
+
+    // written before launching as we may not get back here
+    add_history(path, timeline);
+
+    blit::api.launch(path.c_str());
+
+    error = "Launch failed!";
+}
+
+void LaunchProfiler::render_status(const blit::Rect &r) const {
+    char buf[100];
+
+    blit::screen.pen = blit::Pen(0x88, 0x88, 0x88);
+
+    if(!error.empty()) {
+        blit::screen.pen = blit::Pen(0xFF, 0x50, 0x50);
+        blit::screen.text(error, blit::minimal_font, r, true, blit::TextAlign::center_left);
+        return;
+    }
+
+    if(prewarm.state == State::Verifying) {
+        int percent = prewarm.end ? uint64_t(prewarm.offset) * 100 / prewarm.end : 0;
+        snprintf(buf, sizeof(buf), "Checking... %i%%", percent);
+        blit::screen.text(buf, blit::minimal_font, r, true, blit::TextAlign::center_left);
+    } else if(prewarm.state == State::Done) {
+        auto &t = prewarm.timeline;
+        snprintf(buf, sizeof(buf), "Ready%s (%ums)", t.crc == CRCResult::Bad ? ", CRC mismatch" : "",
+                 unsigned(t.open_us + t.header_us + t.verify_us) / 1000);
+        blit::screen.text(buf, blit::minimal_font, r, true, blit::TextAlign::center_left);
+    }
+
+    // timings from the last launch of this file
+    auto it = last_launch.find(prewarm.path);
+    if(it != last_launch.end()) {
+        auto &t = it->second;
+        snprintf(buf, sizeof(buf), "Last: open %u hdr %u crc %u wait %ums%s", unsigned(t.open_us / 1000), unsigned(t.header_us / 1000),
+                 unsigned(t.verify_us / 1000), unsigned(t.wait_us / 1000), t.prewarmed ? " (pre)" : "");
+        blit::screen.text(buf, blit::minimal_font, r, true, blit::TextAlign::center_right);
+    }
+}
+
+void LaunchProfiler::add_history(const std::string &path, const Timeline &timeline) {
+    last_launch[path] = timeline;
+
+    if(history_filename.empty())
+        return;
+
+    char buf[100];
+    snprintf(buf, sizeof(buf), ",%u,%i,%u,%u,%u,%u,%i\n", unsigned(timeline.size), timeline.prewarmed, unsigned(timeline.open_us),
+             unsigned(timeline.header_us), unsigned(timeline.verify_us), unsigned(timeline.wait_us), int(timeline.crc));
+
+    auto line = path + buf;
+
+    auto mode = blit::file_exists(history_filename) ? blit::OpenMode::read | blit::OpenMode::write : blit::OpenMode::write;
+    blit::File file(history_filename, mode);
+    file.write(file.get_length(), line.length(), line.c_str());
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "engine/file.hpp"
+#include "types/rect.hpp"
+
+// Times the launcher's side of starting a game (open, header, CRC check) and
+// appends it to a history file. The highlighted file is checked in the
+// background after a short delay so launching it doesn't have to wait.
+
+class LaunchProfiler final {
+public:
+    void set_history_file(std::string filename);
+
+    // call every update with the highlighted file ("" if it's not a file)
+    void hover(const std::string &path);
+
+    void update();
+
+    void launch(const std::string &path);
+
+    void render_status(const blit::Rect &r) const;
+
+private:
+    enum class CRCResult : uint8_t {
+        None = 0, // no metadata to check against
+        OK,
+        Bad,
+    };
+
+    struct Timeline {
+        uint32_t open_us = 0, header_us = 0, verify_us = 0;
+        uint32_t wait_us = 0; // from pressing launch to calling api.launch
+        uint32_t size = 0;
+        bool prewarmed = false;
+        CRCResult crc = CRCResult::None;
+    };
+
+    enum class State {
+        Idle,
+        Waiting, // for the hover delay
+        Verifying,
+        Done,
+        Failed,
+    };
+
+    // reading through a file to check it, in steps
+    struct Verify {
+        std::string path;
+        State state = State::Idle;
+        blit::File file;
+
+        uint32_t offset = 0, end = 0;
+        uint32_t crc = 0, expected_crc = 0;
+        bool has_crc = false;
+
+        Timeline timeline;
+
+        bool begin(const std::string &path);
+        void step(uint32_t budget_us);
+    };
+
+    static const uint32_t hover_delay = 300; // ms
+    static const uint32_t prewarm_slice_us = 2000;
+
+    void add_history(const std::string &path, const Timeline &timeline);
+
+    std::string history_filename;
+    std::map<std::string, Timeline> last_launch;
+
+    Verify prewarm;
+    uint32_t hover_start = 0;
+
+    std::string error;
+};
@@ -1,26 +1,65 @@
 #include "launcher-test.hpp"
+#include "catalog.hpp"
 #include "file-browser.hpp"
-
-#include "engine/api_private.hpp"
+#include "filter-benchmark.hpp"
+#include "game-index.hpp"
+#include "launch-profiler.hpp"
 
 FileBrowser file_browser;
+GameCatalog catalog("launcher-catalog.bin");
+GameIndex game_index("launcher-index.txt");
+LaunchProfiler launch_profiler;
+
+std::string benchmark_result;
 
 void launch_game(std::string filename) {
-  blit::api.launch(filename.c_str());
+  launch_profiler.launch(filename);
 }
 
 void init() {
   blit::set_screen_mode(blit::ScreenMode::hires);
 
+  // leave a line for launch status
+  file_browser.set_display_rect({0, 0, blit::screen.bounds.w, blit::screen.bounds.h - 10});
+
   file_browser.set_extensions({".blit"});
   file_browser.set_on_file_open(launch_game);
+  file_browser.set_recent_file("launcher-recent.txt");
+
+  catalog.load();
+  file_browser.set_catalog(&catalog);
+  file_browser.set_game_index(&game_index);
+
   file_browser.init();
+
+  launch_profiler.set_history_file("launch-history.csv");
 }
 
 void render(uint32_t time_ms) {
+  blit::screen.pen = blit::Pen(0x11, 0x11, 0x11);
+  blit::screen.clear();
+
   file_browser.render();
+
+  blit::Rect status_rect(4, blit::screen.bounds.h - 10, blit::screen.bounds.w - 8, 10);
+
+  if(!benchmark_result.empty()) {
+    blit::screen.pen = blit::Pen(0x88, 0x88, 0x88);
+    blit::screen.text(benchmark_result, blit::minimal_font, status_rect, true, blit::TextAlign::center_left);
+  } else
+    launch_profiler.render_status(status_rect);
 }
 
 void update(uint32_t time_ms) {
+  // joystick to benchmark the extension filter, anything else to hide it again
+  if(blit::buttons.pressed & blit::Button::JOYSTICK)
+    benchmark_result = run_filter_benchmark();
+  else if(blit::buttons.pressed)
+    benchmark_result.clear();
+
   file_browser.update(time_ms);
+
+  // check the highlighted game while we wait
+  launch_profiler.hover(file_browser.get_selected_path());
+  launch_profiler.update();
 }
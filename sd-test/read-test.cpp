@@ -0,0 +1,103 @@
+#include <algorithm>
+
+#include "read-test.hpp"
+#include "stats.hpp"
+#include "test-data.hpp"
+
+#include "32blit.hpp"
+#include "engine/api_private.hpp"
+
+static LatencyHistogram latency;
+
+const char *getPatternName(AccessPattern pattern)
+{
+    switch(pattern)
+    {
+        case AccessPattern::Sequential:
+            return "Sequential";
+        case AccessPattern::Random:
+            return "Random";
+        case AccessPattern::Strided:
+            return "Strided";
+        case AccessPattern::Reverse:
+            return "Reverse";
+    }
+
+    return "";
+}
+
+uint32_t getPatternOffset(AccessPattern pattern, uint32_t index, uint32_t chunkSize, uint32_t fileSize)
+{
+    uint32_t count = fileSize / chunkSize;
+
+    switch(pattern)
+    {
+        case AccessPattern::Sequential:
+            break;
+
+        case AccessPattern::Random:
+            return blit::random() % (fileSize - chunkSize + 1);
+
+        case AccessPattern::Strided:
+        {
+            // chunks >= the stride are just sequential
+            uint32_t stride = std::max(readStride, chunkSize);
+            uint32_t perPass = fileSize / stride;
+
+            return (index % perPass) * stride + (index / perPass) * chunkSize;
+        }
+
+        case AccessPattern::Reverse:
+            return (count - 1 - index) * chunkSize;
+    }
+
+    return index * chunkSize;
+}
+
+bool runReadTest(const char *filename, AccessPattern pattern, uint32_t chunkSize, uint32_t seed, uint32_t fileSize, ReadResult &result, std::string &error)
+{
+    blit::File f(filename);
+    auto buf = getWorkBuffer();
+
+    if(!f.is_open())
+    {
+        error = "Failed to open test data!";
+        return false;
+    }
+
+    latency.reset();
+
+    uint32_t count = fileSize / chunkSize;
+    uint32_t total = 0;
+
+    for(uint32_t j = 0; j < count; j++)
+    {
+        uint32_t offset = getPatternOffset(pattern, j, chunkSize, fileSize);
+
+        uint32_t start = blit::api.get_us_timer();
+        auto read = f.read(offset, chunkSize, reinterpret_cast<char *>(buf));
+        uint32_t time = getElapsedTime(start, blit::api.get_us_timer());
+
+        if(read != static_cast<int32_t>(chunkSize))
+        {
+            error = "Read failed!";
+            return false;
+        }
+
+        total += time;
+        latency.add(time);
+
+        if(!verifyTestData(seed, offset, chunkSize, buf))
+        {
+            error = "Data mismatch!";
+            return false;
+        }
+    }
+
+    result.time = total;
+    result.minLatency = latency.get_min();
+    result.medianLatency = latency.get_percentile(50);
+    result.p99Latency = latency.get_percentile(99);
+
+    return true;
+}
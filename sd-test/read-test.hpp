@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+enum class AccessPattern {
+    Sequential = 0,
+    Random,
+    Strided,
+    Reverse
+};
+
+const int numPatterns = 4;
+
+// strided reads jump this far, then go round again shifted by one chunk
+const uint32_t readStride = 4096;
+
+struct ReadResult {
+    uint32_t time; // total
+    uint32_t minLatency, medianLatency, p99Latency;
+};
+
+const char *getPatternName(AccessPattern pattern);
+
+// offset of the index'th read of chunkSize bytes from a file of fileSize bytes
+uint32_t getPatternOffset(AccessPattern pattern, uint32_t index, uint32_t chunkSize, uint32_t fileSize);
+
+// reads all of fileSize in chunkSize reads, checking against the test data for seed
+bool runReadTest(const char *filename, AccessPattern pattern, uint32_t chunkSize, uint32_t seed, uint32_t fileSize, ReadResult &result, std::string &error);
@@ -0,0 +1,134 @@
+#include <cstdlib>
+
+#include "results.hpp"
+
+#include "32blit.hpp"
+
+static const char *csvHeader = "run,suite,mode,size,time_us,mb_s,min_us,median_us,p99_us,max_us,open_us,close_us,read_us\n";
+
+bool appendResults(const char *filename, uint32_t run, const std::string &params, const std::vector<ResultEntry> &entries, std::string &error)
+{
+    bool exists = blit::file_exists(filename);
+
+    std::string out = exists ? "" : csvHeader;
+    out += "# run=" + std::to_string(run) + " " + params + "\n";
+
+    char buf[200];
+
+    for(auto &entry : entries)
+    {
+        snprintf(buf, sizeof(buf), "%u,%s,%s,%u,%u,%.3f,%u,%u,%u,%u,%u,%u,%u\n", static_cast<unsigned>(run), entry.suite.c_str(), entry.mode.c_str(),
+                 static_cast<unsigned>(entry.size), static_cast<unsigned>(entry.time), static_cast<double>(entry.speed),
+                 static_cast<unsigned>(entry.minLatency), static_cast<unsigned>(entry.medianLatency), static_cast<unsigned>(entry.p99Latency),
+                 static_cast<unsigned>(entry.maxLatency), static_cast<unsigned>(entry.openTime), static_cast<unsigned>(entry.closeTime),
+                 static_cast<unsigned>(entry.readTime));
+        out += buf;
+    }
+
+    blit::File f(filename, exists ? blit::OpenMode::read | blit::OpenMode::write : blit::OpenMode::write);
+
+    if(f.write(f.get_length(), out.length(), out.data()) != static_cast<int32_t>(out.length()))
+    {
+        error = "Failed to write results!";
+        return false;
+    }
+
+    return true;
+}
+
+bool loadResults(const char *filename, std::vector<ResultEntry> &entries, uint32_t &run, std::string &error)
+{
+    blit::File f(filename);
+
+    if(!f.is_open())
+    {
+        error = "Failed to open results!";
+        return false;
+    }
+
+    std::string in(f.get_length(), '\0');
+
+    if(f.read(0, in.length(), in.data()) != static_cast<int32_t>(in.length()))
+    {
+        error = "Failed to read results!";
+        return false;
+    }
+
+    entries.clear();
+    run = 0;
+
+    size_t lineStart = 0;
+
+    while(lineStart < in.length())
+    {
+        auto lineEnd = in.find('\n', lineStart);
+        if(lineEnd == std::string::npos)
+            lineEnd = in.length();
+
+        auto line = in.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        // comments and the header
+        if(line.empty() || line[0] == '#' || line.compare(0, 4, "run,") == 0)
+            continue;
+
+        char *end;
+        uint32_t lineRun = strtoul(line.c_str(), &end, 10);
+
+        if(*end != ',')
+            continue;
+
+        // a later run, drop the earlier one
+        if(lineRun != run)
+        {
+            entries.clear();
+            run = lineRun;
+        }
+
+        // split the two names off, the rest is numbers
+        auto suiteStart = end - line.c_str() + 1;
+        auto modeStart = line.find(',', suiteStart);
+        auto modeEnd = modeStart == std::string::npos ? modeStart : line.find(',', modeStart + 1);
+
+        if(modeEnd == std::string::npos)
+            continue;
+
+        ResultEntry entry = {};
+        entry.suite = line.substr(suiteStart, modeStart - suiteStart);
+        entry.mode = line.substr(modeStart + 1, modeEnd - modeStart - 1);
+
+        const char *p = line.c_str() + modeEnd + 1;
+
+        uint32_t *fields[] {&entry.size, &entry.time};
+        for(auto field : fields)
+        {
+            *field = strtoul(p, &end, 10);
+            p = *end == ',' ? end + 1 : end;
+        }
+
+        entry.speed = strtof(p, &end);
+        p = *end == ',' ? end + 1 : end;
+
+        uint32_t *timeFields[] {&entry.minLatency, &entry.medianLatency, &entry.p99Latency, &entry.maxLatency, &entry.openTime, &entry.closeTime, &entry.readTime};
+        for(auto field : timeFields)
+        {
+            *field = strtoul(p, &end, 10);
+            p = *end == ',' ? end + 1 : end;
+        }
+
+        entries.push_back(entry);
+    }
+
+    return true;
+}
+
+const ResultEntry *findResult(const std::vector<ResultEntry> &entries, const ResultEntry &entry)
+{
+    for(auto &e : entries)
+    {
+        if(e.size == entry.size && e.suite == entry.suite && e.mode == entry.mode)
+            return &e;
+    }
+
+    return nullptr;
+}
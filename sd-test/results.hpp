@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// one line of the exported csv, times are in us, zero where they don't apply
+struct ResultEntry {
+    std::string suite, mode;
+    uint32_t size; // chunk/file size or file count
+
+    uint32_t time; // read/write/list
+    float speed;   // MB/s
+
+    uint32_t minLatency, medianLatency, p99Latency, maxLatency;
+    uint32_t openTime, closeTime, readTime;
+};
+
+// adds a run to the end of the file, params ends up in a # comment above it
+bool appendResults(const char *filename, uint32_t run, const std::string &params, const std::vector<ResultEntry> &entries, std::string &error);
+
+// only loads the last run in the file
+bool loadResults(const char *filename, std::vector<ResultEntry> &entries, uint32_t &run, std::string &error);
+
+// same suite/mode/size
+const ResultEntry *findResult(const std::vector<ResultEntry> &entries, const ResultEntry &entry);
@@ -0,0 +1,247 @@
+#include <algorithm>
+
+#include "scaling-test.hpp"
+#include "stats.hpp"
+#include "test-data.hpp"
+
+#include "32blit.hpp"
+#include "engine/api_private.hpp"
+
+enum class Phase {
+    Start,
+
+    // file size
+    Write,
+    Read,
+
+    // file count
+    Create,
+    List,
+    Open
+};
+
+static const uint32_t sliceTime = 20000; // us
+static const uint32_t chunkSize = 0x8000;
+static const uint32_t countFileSize = 512;
+
+static const char *sizeFilename = "sdscale.dat";
+
+static Phase phase = Phase::Start;
+static blit::File file;
+static uint32_t offset = 0; // bytes for size, files for count
+static uint32_t openTotal = 0;
+static uint32_t progress = 0, progressTotal = 1;
+
+const char *getScaleModeName(ScaleMode mode)
+{
+    switch(mode)
+    {
+        case ScaleMode::FileSize:
+            return "File size";
+        case ScaleMode::FileCount:
+            return "File count";
+    }
+
+    return "";
+}
+
+static bool sliceExpired(uint32_t sliceStart)
+{
+    return getElapsedTime(sliceStart, blit::api.get_us_timer()) >= sliceTime;
+}
+
+static bool fail(const char *message, std::string &error)
+{
+    error = message;
+    file.close();
+    phase = Phase::Start;
+    return false;
+}
+
+bool updateFileSizeTest(int index, uint32_t seed, FileSizeResult &result, std::string &error)
+{
+    const uint32_t fileSize = scaleFileSizes[index];
+    auto buf = getWorkBuffer();
+    uint32_t sliceStart = blit::api.get_us_timer();
+
+    if(phase == Phase::Start)
+    {
+        result.writeTime = result.readTime = 0;
+        offset = 0;
+        progress = 0;
+        progressTotal = fileSize * 2;
+
+        uint32_t start = blit::api.get_us_timer();
+        bool opened = file.open(sizeFilename, blit::OpenMode::write);
+        result.writeTime += getElapsedTime(start, blit::api.get_us_timer());
+
+        if(!opened)
+            return fail("Failed to create scaling test file!", error);
+
+        phase = Phase::Write;
+    }
+
+    while(phase == Phase::Write && !sliceExpired(sliceStart))
+    {
+        generateTestData(seed, offset, chunkSize, buf);
+
+        uint32_t start = blit::api.get_us_timer();
+        auto written = file.write(offset, chunkSize, reinterpret_cast<const char *>(buf));
+        result.writeTime += getElapsedTime(start, blit::api.get_us_timer());
+
+        if(written != static_cast<int32_t>(chunkSize))
+            return fail("Write failed!", error);
+
+        offset += chunkSize;
+        progress += chunkSize;
+
+        if(offset == fileSize)
+        {
+            start = blit::api.get_us_timer();
+            file.close();
+            result.writeTime += getElapsedTime(start, blit::api.get_us_timer());
+
+            start = blit::api.get_us_timer();
+            bool opened = file.open(sizeFilename);
+            result.readTime += getElapsedTime(start, blit::api.get_us_timer());
+
+            if(!opened)
+                return fail("Failed to open scaling test file!", error);
+
+            offset = 0;
+            phase = Phase::Read;
+        }
+    }
+
+    while(phase == Phase::Read && !sliceExpired(sliceStart))
+    {
+        uint32_t start = blit::api.get_us_timer();
+        auto read = file.read(offset, chunkSize, reinterpret_cast<char *>(buf));
+        result.readTime += getElapsedTime(start, blit::api.get_us_timer());
+
+        if(read != static_cast<int32_t>(chunkSize))
+            return fail("Read failed!", error);
+
+        if(!verifyTestData(seed, offset, chunkSize, buf))
+            return fail("Data mismatch!", error);
+
+        offset += chunkSize;
+        progress += chunkSize;
+
+        if(offset == fileSize)
+        {
+            file.close();
+
+            // don't leave 32MB lying around
+            blit::remove_file(sizeFilename);
+
+            phase = Phase::Start;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool updateFileCountTest(int index, FileCountResult &result, std::string &error)
+{
+    const uint32_t count = scaleDirCounts[index];
+    uint32_t sliceStart = blit::api.get_us_timer();
+
+    char dir[32], path[48];
+    snprintf(dir, sizeof(dir), "sdscale/%i", static_cast<int>(count));
+
+    if(phase == Phase::Start)
+    {
+        if(!blit::directory_exists("sdscale"))
+            blit::create_directory("sdscale");
+
+        if(!blit::directory_exists(dir) && !blit::create_directory(dir))
+            return fail("Failed to create scaling test directory!", error);
+
+        result.listTime = result.avgOpenTime = result.maxOpenTime = 0;
+        offset = 0;
+        openTotal = 0;
+        progress = 0;
+        progressTotal = count * 2;
+
+        phase = Phase::Create;
+    }
+
+    // files are kept between runs, so this only has to happen once
+    while(phase == Phase::Create && !sliceExpired(sliceStart))
+    {
+        snprintf(path, sizeof(path), "%s/%04i.dat", dir, static_cast<int>(offset));
+
+        if(!blit::file_exists(path))
+        {
+            static const char fileData[countFileSize] = {};
+            blit::File f(path, blit::OpenMode::write);
+
+            if(f.write(0, countFileSize, fileData) != static_cast<int32_t>(countFileSize))
+                return fail("Failed to create scaling test files!", error);
+        }
+
+        offset++;
+        progress++;
+
+        if(offset == count)
+            phase = Phase::List;
+    }
+
+    if(phase == Phase::List && !sliceExpired(sliceStart))
+    {
+        uint32_t start = blit::api.get_us_timer();
+        auto files = blit::list_files(dir);
+        result.listTime = getElapsedTime(start, blit::api.get_us_timer());
+
+        if(files.size() < count)
+            return fail("Directory listing is missing files!", error);
+
+        offset = 0;
+        phase = Phase::Open;
+    }
+
+    while(phase == Phase::Open && !sliceExpired(sliceStart))
+    {
+        snprintf(path, sizeof(path), "%s/%04i.dat", dir, static_cast<int>(offset));
+
+        uint32_t start = blit::api.get_us_timer();
+        blit::File f(path);
+        uint32_t time = getElapsedTime(start, blit::api.get_us_timer());
+
+        if(!f.is_open())
+            return fail("Failed to open scaling test file!", error);
+
+        openTotal += time;
+        result.maxOpenTime = std::max(result.maxOpenTime, time);
+
+        offset++;
+        progress++;
+
+        if(offset == count)
+        {
+            result.avgOpenTime = openTotal / count;
+            phase = Phase::Start;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int getScalingProgress()
+{
+    return static_cast<uint64_t>(progress) * 100 / progressTotal;
+}
+
+void cancelScalingTest()
+{
+    if(phase == Phase::Write || phase == Phase::Read)
+    {
+        file.close();
+        blit::remove_file(sizeFilename);
+    }
+
+    phase = Phase::Start;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+enum class ScaleMode {
+    FileSize = 0,
+    FileCount
+};
+
+const int numScaleModes = 2;
+
+const int numScaleFileSizes = 4;
+const uint32_t scaleFileSizes[numScaleFileSizes] = {
+    64 * 1024,
+    1024 * 1024,
+    8 * 1024 * 1024,
+    32 * 1024 * 1024
+};
+
+const int numScaleDirs = 3;
+const int scaleDirCounts[numScaleDirs] = {10, 100, 1000};
+
+struct FileSizeResult {
+    uint32_t writeTime, readTime;
+};
+
+struct FileCountResult {
+    uint32_t listTime;
+    uint32_t avgOpenTime, maxOpenTime;
+};
+
+const char *getScaleModeName(ScaleMode mode);
+
+// These do a slice of the work each call so the screen can keep updating,
+// returning true once the size/count is finished.
+
+// writes a file of scaleFileSizes[index], reads it back and deletes it
+bool updateFileSizeTest(int index, uint32_t seed, FileSizeResult &result, std::string &error);
+
+// fills a directory with scaleDirCounts[index] files (kept for next time), then times listing it and opening each file
+bool updateFileCountTest(int index, FileCountResult &result, std::string &error);
+
+// of the current size/count, 0-100
+int getScalingProgress();
+
+// abandons a partially finished size/count, the next update starts it again
+void cancelScalingTest();
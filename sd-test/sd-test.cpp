@@ -1,39 +1,504 @@
+#include <algorithm>
 #include <cstring>
 
 #include "sd-test.hpp"
+#include "read-test.hpp"
+#include "results.hpp"
+#include "scaling-test.hpp"
+#include "stream-test.hpp"
+#include "stats.hpp"
+#include "test-data.hpp"
+#include "write-test.hpp"
 #include "engine/api_private.hpp"
 
+enum class Suite {
+    Read = 0,
+    Write,
+    Scaling,
+    Stream
+};
+
+const int numSuites = 4;
+const int suiteModes[numSuites] = {numPatterns, numWriteModes, numScaleModes, numStreamModes};
+const int maxModes = 4;
+
 const int testSize = 0x10000;
 const int numTests = 17;
 
 uint32_t writeTime = 0;
 size_t numFiles = 0;
-uint32_t results[numTests];
-int curTest = 0;
+ReadResult readResults[numPatterns][numTests];
+WriteResult writeResults[numWriteModes][numTests];
+FileSizeResult fileSizeResults[numScaleFileSizes];
+FileCountResult fileCountResults[numScaleDirs];
+StreamResult streamResults[numStreamModes][numStreamBudgets];
+int curTest[numSuites][maxModes] = {};
+int curSuite = 0;
+int curMode[numSuites] = {};
 
-uint8_t testData[testSize];
+uint32_t testSeed;
+
+const char *resultsFilename = "sdtest-results.csv";
+std::vector<ResultEntry> baseline; // previous export
+uint32_t lastRun = 0; // each export is a new run in the file
+bool compareView = false;
+std::string status;
 
 std::string error;
 
-uint32_t getElapsedTime(uint32_t start, uint32_t end)
+// scales bytes/us to something readable
+static float getSpeed(uint32_t bytes, uint32_t time, const char *&unit)
+{
+    float speed = static_cast<float>(bytes) / (static_cast<float>(time) / 1000000.0f);
+    unit = "B";
+
+    if(speed >= 1000.0f)
+    {
+        speed /= 1000.0f;
+        unit = "kB";
+    }
+
+    if(speed >= 1000.0f)
+    {
+        speed /= 1000.0f;
+        unit = "MB";
+    }
+
+    return speed;
+}
+
+static const char *getModeName(Suite suite, int mode)
+{
+    switch(suite)
+    {
+        case Suite::Read:
+            return getPatternName(static_cast<AccessPattern>(mode));
+        case Suite::Write:
+            return getWriteModeName(static_cast<WriteMode>(mode));
+        case Suite::Scaling:
+            return getScaleModeName(static_cast<ScaleMode>(mode));
+        case Suite::Stream:
+            return getStreamModeName(static_cast<StreamMode>(mode));
+    }
+
+    return "";
+}
+
+static const char *getSuiteName(Suite suite)
+{
+    switch(suite)
+    {
+        case Suite::Read:
+            return "Read";
+        case Suite::Write:
+            return "Write";
+        case Suite::Scaling:
+            return "Scaling";
+        case Suite::Stream:
+            return "Stream";
+    }
+
+    return "";
+}
+
+static int getNumTests(Suite suite, int mode)
+{
+    if(suite == Suite::Stream)
+        return numStreamBudgets;
+
+    if(suite != Suite::Scaling)
+        return numTests;
+
+    return static_cast<ScaleMode>(mode) == ScaleMode::FileSize ? numScaleFileSizes : numScaleDirs;
+}
+
+// bars scaled to the largest value, b is optional and drawn alongside a
+static void renderBarChart(const blit::Rect &r, const char *const *labels, int count, const float *a, const float *b = nullptr)
+{
+    float maxA = 0.0f, maxB = 0.0f;
+
+    for(int i = 0; i < count; i++)
+    {
+        maxA = std::max(maxA, a[i]);
+        if(b)
+            maxB = std::max(maxB, b[i]);
+    }
+
+    const int labelH = 10;
+    int slotW = r.w / count;
+    int barW = b ? slotW / 3 : slotW / 2;
+    int maxH = r.h - labelH;
+
+    blit::screen.pen = blit::Pen(80, 90, 100);
+    blit::screen.h_span({r.x, r.y + maxH}, r.w);
+
+    for(int i = 0; i < count; i++)
+    {
+        int x = r.x + i * slotW + (slotW - (b ? barW * 2 : barW)) / 2;
+
+        if(maxA > 0.0f)
+        {
+            int h = static_cast<int>(a[i] / maxA * maxH);
+            blit::screen.pen = blit::Pen(0, 160, 255);
+            blit::screen.rectangle({x, r.y + maxH - h, barW, h});
+        }
+
+        if(b && maxB > 0.0f)
+        {
+            int h = static_cast<int>(b[i] / maxB * maxH);
+            blit::screen.pen = blit::Pen(255, 160, 0);
+            blit::screen.rectangle({x + barW, r.y + maxH - h, barW, h});
+        }
+
+        blit::screen.pen = blit::Pen(255, 255, 255);
+        blit::screen.text(labels[i], blit::minimal_font, blit::Point(r.x + i * slotW + slotW / 2, r.y + maxH + 2), true, blit::TextAlign::top_center);
+    }
+}
+
+static void renderReadResults(int mode, int y)
+{
+    char buf[100];
+
+    blit::screen.text(" size      total        speed   min   med   p99", blit::minimal_font, blit::Point(0, y), false);
+    y += 10;
+
+    for(int i = 0; i < curTest[int(Suite::Read)][mode]; i++)
+    {
+        auto &result = readResults[mode][i];
+
+        const char *unit;
+        float speed = getSpeed(testSize, result.time, unit);
+
+        snprintf(buf, 100, "%5i %8ius %7.3f%2s/s %5i %5i %5i\n", 1 << i, result.time, (double)speed, unit,
+                 result.minLatency, result.medianLatency, result.p99Latency);
+        blit::screen.text(buf, blit::minimal_font, blit::Point(0, y), false);
+
+        y += 10;
+    }
+}
+
+static void renderWriteResults(int mode, int y)
+{
+    char buf[100];
+
+    bool mixed = static_cast<WriteMode>(mode) == WriteMode::Mixed;
+
+    blit::screen.text(mixed ? " size  open    rd+wr close        speed   p99" : " size  open    write close        speed   p99", blit::minimal_font, blit::Point(0, y), false);
+    y += 10;
+
+    for(int i = 0; i < curTest[int(Suite::Write)][mode]; i++)
+    {
+        auto &result = writeResults[mode][i];
+
+        // mixed reads as much as it writes
+        uint32_t time = result.writeTime + result.readTime;
+        const char *unit;
+        float speed = getSpeed(mixed ? testSize * 2 : testSize, time, unit);
+
+        snprintf(buf, 100, "%5i %5i %8i %5i %7.3f%2s/s %5i\n", 1 << i, result.openTime, time, result.closeTime, (double)speed, unit, result.p99Latency);
+        blit::screen.text(buf, blit::minimal_font, blit::Point(0, y), false);
+
+        y += 10;
+    }
+}
+
+static void renderScalingResults(int mode, int y)
+{
+    char buf[100];
+    int done = curTest[int(Suite::Scaling)][mode];
+
+    const char *labels[std::max(numScaleFileSizes, numScaleDirs)];
+    char labelBuf[std::max(numScaleFileSizes, numScaleDirs)][8];
+    float a[std::max(numScaleFileSizes, numScaleDirs)] = {};
+    float b[std::max(numScaleFileSizes, numScaleDirs)] = {};
+
+    const char *aLabel, *bLabel = nullptr;
+
+    if(static_cast<ScaleMode>(mode) == ScaleMode::FileSize)
+    {
+        blit::screen.text(" size      write        speed      read        speed", blit::minimal_font, blit::Point(0, y), false);
+        y += 10;
+
+        for(int i = 0; i < numScaleFileSizes; i++)
+        {
+            uint32_t size = scaleFileSizes[i];
+
+            if(size >= 1024 * 1024)
+                snprintf(labelBuf[i], sizeof(labelBuf[i]), "%iM", static_cast<int>(size / (1024 * 1024)));
+            else
+                snprintf(labelBuf[i], sizeof(labelBuf[i]), "%ik", static_cast<int>(size / 1024));
+
+            labels[i] = labelBuf[i];
+
+            if(i >= done)
+                continue;
+
+            auto &result = fileSizeResults[i];
+
+            const char *writeUnit, *readUnit;
+            float writeSpeed = getSpeed(size, result.writeTime, writeUnit);
+            float readSpeed = getSpeed(size, result.readTime, readUnit);
+
+            snprintf(buf, 100, "%5s %8ius %7.3f%2s/s %8ius %7.3f%2s/s\n", labels[i], result.writeTime, (double)writeSpeed, writeUnit,
+                     result.readTime, (double)readSpeed, readUnit);
+            blit::screen.text(buf, blit::minimal_font, blit::Point(0, y), false);
+
+            // MB/s
+            a[i] = static_cast<float>(size) / result.readTime;
+
+            y += 10;
+        }
+
+        aLabel = "read MB/s";
+    }
+    else
+    {
+        blit::screen.text("files       list    open avg    open max", blit::minimal_font, blit::Point(0, y), false);
+        y += 10;
+
+        for(int i = 0; i < numScaleDirs; i++)
+        {
+            snprintf(labelBuf[i], sizeof(labelBuf[i]), "%i", scaleDirCounts[i]);
+            labels[i] = labelBuf[i];
+
+            if(i >= done)
+                continue;
+
+            auto &result = fileCountResults[i];
+
+            snprintf(buf, 100, "%5i %9ius %9ius %9ius\n", scaleDirCounts[i], result.listTime, result.avgOpenTime, result.maxOpenTime);
+            blit::screen.text(buf, blit::minimal_font, blit::Point(0, y), false);
+
+            a[i] = result.listTime;
+            b[i] = result.avgOpenTime;
+
+            y += 10;
+        }
+
+        aLabel = "list_files";
+        bLabel = "open";
+    }
+
+    int numResults = getNumTests(Suite::Scaling, mode);
+
+    if(done < numResults && error.empty())
+    {
+        snprintf(buf, 100, "Running %s... %i%%", labels[done], getScalingProgress());
+        blit::screen.text(buf, blit::minimal_font, blit::Point(0, y));
+    }
+
+    // chart + legend
+    y = 110;
+    blit::screen.pen = blit::Pen(0, 160, 255);
+    blit::screen.text(aLabel, blit::minimal_font, blit::Point(0, y));
+
+    if(bLabel)
+    {
+        blit::screen.pen = blit::Pen(255, 160, 0);
+        blit::screen.text(bLabel, blit::minimal_font, blit::Point(blit::screen.bounds.w, y), true, blit::TextAlign::top_right);
+    }
+
+    renderBarChart({0, y + 10, blit::screen.bounds.w, 90}, labels, numResults, a, bLabel ? b : nullptr);
+}
+
+static void renderStreamResults(int mode, int y)
+{
+    char buf[100];
+
+    blit::screen.text("budget        speed    med    p99    max stalls", blit::minimal_font, blit::Point(0, y), false);
+    y += 10;
+
+    int done = curTest[int(Suite::Stream)][mode];
+
+    for(int i = 0; i < done; i++)
+    {
+        auto &result = streamResults[mode][i];
+
+        const char *unit;
+        float speed = getSpeed(result.bytes, result.wallTime, unit);
+
+        snprintf(buf, 100, "%5ius %7.3f%2s/s %6i %6i %6i %6i\n", streamBudgets[i], (double)speed, unit,
+                 result.medianUpdate, result.p99Update, result.maxUpdate, result.stalls);
+        blit::screen.text(buf, blit::minimal_font, blit::Point(0, y), false);
+
+        y += 10;
+    }
+
+    if(done < numStreamBudgets && error.empty())
+    {
+        snprintf(buf, 100, "Streaming with %ius per update...", streamBudgets[done]);
+        blit::screen.text(buf, blit::minimal_font, blit::Point(0, y));
+    }
+}
+
+static void collectResults(std::vector<ResultEntry> &entries)
+{
+    entries.clear();
+
+    auto newEntry = [&entries](Suite suite, int mode, uint32_t size) -> ResultEntry & {
+        ResultEntry entry = {};
+        entry.suite = getSuiteName(suite);
+        entry.mode = getModeName(suite, mode);
+        entry.size = size;
+        entries.push_back(entry);
+        return entries.back();
+    };
+
+    for(int mode = 0; mode < numPatterns; mode++)
+    {
+        for(int i = 0; i < curTest[int(Suite::Read)][mode]; i++)
+        {
+            auto &result = readResults[mode][i];
+            auto &entry = newEntry(Suite::Read, mode, 1 << i);
+
+            entry.time = result.time;
+            entry.speed = static_cast<float>(testSize) / result.time;
+            entry.minLatency = result.minLatency;
+            entry.medianLatency = result.medianLatency;
+            entry.p99Latency = result.p99Latency;
+        }
+    }
+
+    for(int mode = 0; mode < numWriteModes; mode++)
+    {
+        for(int i = 0; i < curTest[int(Suite::Write)][mode]; i++)
+        {
+            auto &result = writeResults[mode][i];
+            auto &entry = newEntry(Suite::Write, mode, 1 << i);
+
+            uint32_t bytes = static_cast<WriteMode>(mode) == WriteMode::Mixed ? testSize * 2 : testSize;
+
+            entry.time = result.writeTime;
+            entry.speed = static_cast<float>(bytes) / (result.writeTime + result.readTime);
+            entry.minLatency = result.minLatency;
+            entry.medianLatency = result.medianLatency;
+            entry.p99Latency = result.p99Latency;
+            entry.openTime = result.openTime;
+            entry.closeTime = result.closeTime;
+            entry.readTime = result.readTime;
+        }
+    }
+
+    for(int i = 0; i < curTest[int(Suite::Scaling)][int(ScaleMode::FileSize)]; i++)
+    {
+        auto &result = fileSizeResults[i];
+        auto &entry = newEntry(Suite::Scaling, int(ScaleMode::FileSize), scaleFileSizes[i]);
+
+        // read speed, the write speed can be worked out from the time
+        entry.time = result.writeTime;
+        entry.speed = static_cast<float>(scaleFileSizes[i]) / result.readTime;
+        entry.readTime = result.readTime;
+    }
+
+    for(int i = 0; i < curTest[int(Suite::Scaling)][int(ScaleMode::FileCount)]; i++)
+    {
+        auto &result = fileCountResults[i];
+        auto &entry = newEntry(Suite::Scaling, int(ScaleMode::FileCount), scaleDirCounts[i]);
+
+        // list time, average/max open time
+        entry.time = result.listTime;
+        entry.openTime = result.avgOpenTime;
+        entry.maxLatency = result.maxOpenTime;
+    }
+
+    for(int mode = 0; mode < numStreamModes; mode++)
+    {
+        for(int i = 0; i < curTest[int(Suite::Stream)][mode]; i++)
+        {
+            auto &result = streamResults[mode][i];
+            auto &entry = newEntry(Suite::Stream, mode, streamBudgets[i]);
+
+            // size is the budget, latencies are per update
+            entry.time = result.wallTime;
+            entry.speed = static_cast<float>(result.bytes) / result.wallTime;
+            entry.medianLatency = result.medianUpdate;
+            entry.p99Latency = result.p99Update;
+        }
+    }
+}
+
+static void exportResults()
 {
-    if(end >= start)
-        return end - start;
+    std::vector<ResultEntry> entries;
+    collectResults(entries);
+
+    char params[100];
+    snprintf(params, sizeof(params), "test_size=%i seed=%u root_files=%i create_us=%u", testSize,
+             static_cast<unsigned>(testSeed), static_cast<int>(numFiles), static_cast<unsigned>(writeTime));
+
+    std::string saveError;
+    if(appendResults(resultsFilename, lastRun + 1, params, entries, saveError))
+    {
+        lastRun++;
+        status = "Exported " + std::to_string(entries.size()) + " results (run " + std::to_string(lastRun) + ")";
+    }
     else
-        return (blit::api.get_max_us_timer() - start) + end;
+        status = saveError;
+}
+
+// previous vs current speed (or time if there isn't one) for the selected suite/mode
+static void renderCompare(Suite suite, int mode, int y)
+{
+    char buf[100];
+
+    blit::screen.text("     size          old           new   slower", blit::minimal_font, blit::Point(0, y), false);
+    y += 10;
+
+    std::vector<ResultEntry> entries;
+    collectResults(entries);
+
+    std::string suiteName = getSuiteName(suite), modeName = getModeName(suite, mode);
+
+    for(auto &entry : entries)
+    {
+        if(entry.suite != suiteName || entry.mode != modeName)
+            continue;
+
+        auto old = findResult(baseline, entry);
+        if(!old)
+            continue;
+
+        bool useSpeed = old->speed > 0.0f && entry.speed > 0.0f;
+        float oldVal = useSpeed ? old->speed : old->time + old->readTime;
+        float newVal = useSpeed ? entry.speed : entry.time + entry.readTime;
+
+        // as a percentage of the old time, so +100% is twice as slow either way
+        float change = 0.0f;
+        if(useSpeed)
+            change = (oldVal / newVal - 1.0f) * 100.0f;
+        else if(oldVal > 0.0f)
+            change = (newVal / oldVal - 1.0f) * 100.0f;
+
+        if(change > 10.0f)
+            blit::screen.pen = blit::Pen(0xFF, 0x40, 0x40);
+        else if(change < -10.0f)
+            blit::screen.pen = blit::Pen(0x40, 0xFF, 0x40);
+        else
+            blit::screen.pen = blit::Pen(255, 255, 255);
+
+        const char *format = useSpeed ? "%9u %8.3fMB/s %8.3fMB/s %+7.1f%%\n" : "%9u %10.0fus %10.0fus %+7.1f%%\n";
+        snprintf(buf, 100, format, static_cast<unsigned>(entry.size), static_cast<double>(oldVal), static_cast<double>(newVal), static_cast<double>(change));
+        blit::screen.text(buf, blit::minimal_font, blit::Point(0, y), false);
+
+        y += 10;
+    }
+
+    blit::screen.pen = blit::Pen(255, 255, 255);
 }
 
 void init()
 {
     blit::set_screen_mode(blit::ScreenMode::hires);
 
-    for(auto &b : testData)
-        b = blit::random();
+    testSeed = blit::random();
+
+    auto testData = getWorkBuffer();
+    generateTestData(testSeed, 0, testSize, testData);
 
     auto start = blit::api.get_us_timer();
     blit::File f("sdtest.dat", blit::OpenMode::write);
 
-    auto written = f.write(0, sizeof(testData), reinterpret_cast<const char *>(testData));
+    auto written = f.write(0, testSize, reinterpret_cast<const char *>(testData));
     f.close();
 
     if(written != testSize)
@@ -42,6 +507,11 @@ void init()
         writeTime = getElapsedTime(start, blit::api.get_us_timer());
 
     numFiles = blit::list_files("").size();
+
+    // last export is what we compare against
+    std::string loadError;
+    if(blit::file_exists(resultsFilename) && loadResults(resultsFilename, baseline, lastRun, loadError))
+        status = "Loaded " + std::to_string(baseline.size()) + " previous results";
 }
 
 void render(uint32_t time_ms)
@@ -62,29 +532,39 @@ void render(uint32_t time_ms)
     blit::screen.text(buf, blit::minimal_font, blit::Point(0, y));
     y+= 15;
 
-    for(int i = 0; i < curTest; i++)
-    {
-        float speed = static_cast<float>(testSize) / (static_cast<float>(results[i]) / 1000000.0f);
-        const char *unit = "B";
+    auto suite = static_cast<Suite>(curSuite);
+    int mode = curMode[curSuite];
 
-        if(speed >= 1000.0f)
-        {
-            speed /= 1000.0f;
-            unit = "kB";
-        }
+    blit::screen.text(status, blit::minimal_font, blit::Point(blit::screen.bounds.w, 0), true, blit::TextAlign::top_right);
+    blit::screen.text(baseline.empty() ? "A: export" : "A: export B: compare", blit::minimal_font, blit::Point(blit::screen.bounds.w, 10), true, blit::TextAlign::top_right);
+
+    snprintf(buf, 100, "%s: < %s >%s", getSuiteName(suite), getModeName(suite, mode), compareView ? " (vs. previous)" : "");
+    blit::screen.text(buf, blit::minimal_font, blit::Point(blit::screen.bounds.w / 2, y), true, blit::TextAlign::top_center);
+    y += 10;
 
-        if(speed >= 1000.0f)
+    if(compareView)
+        renderCompare(suite, mode, y);
+    else
+    {
+        switch(suite)
         {
-            speed /= 1000.0f;
-            unit = "MB";
+            case Suite::Read:
+                renderReadResults(mode, y);
+                break;
+            case Suite::Write:
+                renderWriteResults(mode, y);
+                break;
+            case Suite::Scaling:
+                renderScalingResults(mode, y);
+                break;
+            case Suite::Stream:
+                renderStreamResults(mode, y);
+                break;
         }
-
-        snprintf(buf, 100, "read %5i bytes x%5i in %5ius %3.3f%s/s\n", 1 << i, testSize >> i, results[i], (double)speed, unit);
-        blit::screen.text(buf, blit::minimal_font, blit::Point(0, y), false);
-
-        y += 10;
     }
 
+    y = 220;
+
     if(!error.empty())
     {
         y += 5;
@@ -95,27 +575,68 @@ void render(uint32_t time_ms)
 
 void update(uint32_t time_ms)
 {
-    if(curTest < numTests && error.empty())
+    int prevSuite = curSuite, prevMode = curMode[curSuite];
+
+    // switch suite/mode, untested modes run when selected
+    if(blit::buttons.released & blit::Button::DPAD_UP)
+        curSuite = curSuite == 0 ? numSuites - 1 : curSuite - 1;
+    else if(blit::buttons.released & blit::Button::DPAD_DOWN)
+        curSuite = (curSuite + 1) % numSuites;
+
+    int &mode = curMode[curSuite];
+    int numModes = suiteModes[curSuite];
+
+    if(blit::buttons.released & blit::Button::DPAD_LEFT)
+        mode = mode == 0 ? numModes - 1 : mode - 1;
+    else if(blit::buttons.released & blit::Button::DPAD_RIGHT)
+        mode = (mode + 1) % numModes;
+
+    if(curSuite != prevSuite || mode != prevMode)
     {
-        blit::File f("sdtest.dat");
-        char buf[testSize];
+        cancelScalingTest();
+        cancelStreamTest();
+    }
+
+    if(blit::buttons.released & blit::Button::A)
+        exportResults();
 
-        int size = 1 << curTest;
-        int count = testSize >> curTest;
+    if((blit::buttons.released & blit::Button::B) && !baseline.empty())
+        compareView = !compareView;
 
-        uint32_t start = blit::api.get_us_timer();
-        for(int j = 0; j < count; j++)
+    int &test = curTest[curSuite][mode];
+
+    if(test >= getNumTests(static_cast<Suite>(curSuite), mode) || !error.empty())
+        return;
+
+    bool ok = false;
+
+    switch(static_cast<Suite>(curSuite))
+    {
+        case Suite::Read:
+            ok = runReadTest("sdtest.dat", static_cast<AccessPattern>(mode), 1 << test, testSeed, testSize, readResults[mode][test], error);
+            break;
+
+        case Suite::Write:
         {
-            if(f.read(j * size, size, buf + j * size) != size)
-            {
-                error = "Read failed!";
-                break;
-            }
+            // overwrite/mixed write the same data back over the read test file
+            auto writeMode = static_cast<WriteMode>(mode);
+            auto filename = writeMode == WriteMode::Append ? "sdwrite.dat" : "sdtest.dat";
+            ok = runWriteTest(filename, writeMode, 1 << test, testSeed, testSize, writeResults[mode][test], error);
+            break;
         }
 
-        results[curTest++] = getElapsedTime(start, blit::api.get_us_timer());
+        case Suite::Scaling:
+            if(static_cast<ScaleMode>(mode) == ScaleMode::FileSize)
+                ok = updateFileSizeTest(test, testSeed, fileSizeResults[test], error);
+            else
+                ok = updateFileCountTest(test, fileCountResults[test], error);
+            break;
 
-        if(memcmp(buf, testData, testSize) != 0)
-            error = "Data mismatch!";
+        case Suite::Stream:
+            ok = updateStreamTest("sdtest.dat", static_cast<StreamMode>(mode), test, testSeed, testSize, streamResults[mode][test], error);
+            break;
     }
+
+    if(ok)
+        test++;
 }
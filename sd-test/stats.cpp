@@ -0,0 +1,77 @@
+#include <algorithm>
+
+#include "stats.hpp"
+
+#include "engine/api_private.hpp"
+
+uint32_t getElapsedTime(uint32_t start, uint32_t end)
+{
+    if(end >= start)
+        return end - start;
+    else
+        return (blit::api.get_max_us_timer() - start) + end;
+}
+
+void LatencyHistogram::reset()
+{
+    std::fill(std::begin(buckets), std::end(buckets), 0);
+    count = 0;
+    min = ~0u;
+    max = 0;
+}
+
+void LatencyHistogram::add(uint32_t us)
+{
+    buckets[get_bucket(us)]++;
+    count++;
+
+    min = std::min(min, us);
+    max = std::max(max, us);
+}
+
+uint32_t LatencyHistogram::get_percentile(int percent) const
+{
+    if(!count)
+        return 0;
+
+    // rank of the sample we want, rounded up
+    uint32_t target = (static_cast<uint64_t>(count) * percent + 99) / 100;
+    if(!target)
+        target = 1;
+
+    uint32_t seen = 0;
+    for(int i = 0; i < numBuckets; i++)
+    {
+        seen += buckets[i];
+        if(seen >= target)
+            return std::max(min, std::min(max, get_bucket_max(i)));
+    }
+
+    return max;
+}
+
+int LatencyHistogram::get_bucket(uint32_t us)
+{
+    if(us < linearBuckets)
+        return us;
+
+    int log = 4;
+    while(log < 31 && (us >> (log + 1)))
+        log++;
+
+    // top three bits below the highest set bit
+    int sub = (us >> (log - 3)) & (subBuckets - 1);
+
+    return linearBuckets + (log - 4) * subBuckets + sub;
+}
+
+uint32_t LatencyHistogram::get_bucket_max(int bucket)
+{
+    if(bucket < linearBuckets)
+        return bucket;
+
+    int log = (bucket - linearBuckets) / subBuckets + 4;
+    int sub = (bucket - linearBuckets) % subBuckets;
+
+    return ((static_cast<uint64_t>(subBuckets + sub + 1)) << (log - 3)) - 1;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+uint32_t getElapsedTime(uint32_t start, uint32_t end);
+
+// Bucketed per-call latency. Exact below 16us, then 8 buckets per power of two
+// so percentiles are within ~12% without keeping every sample around.
+class LatencyHistogram final {
+public:
+    void reset();
+
+    void add(uint32_t us);
+
+    uint32_t get_count() const {return count;}
+    uint32_t get_min() const {return count ? min : 0;}
+    uint32_t get_max() const {return max;}
+
+    uint32_t get_percentile(int percent) const;
+
+private:
+    static const int linearBuckets = 16;
+    static const int subBuckets = 8;
+    static const int numBuckets = linearBuckets + (32 - 4) * subBuckets;
+
+    static int get_bucket(uint32_t us);
+    static uint32_t get_bucket_max(int bucket);
+
+    uint32_t buckets[numBuckets] = {};
+    uint32_t count = 0;
+    uint32_t min = ~0u, max = 0;
+};
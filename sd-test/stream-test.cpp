@@ -0,0 +1,154 @@
+#include <algorithm>
+
+#include "stream-test.hpp"
+#include "stats.hpp"
+#include "test-data.hpp"
+
+#include "32blit.hpp"
+#include "engine/api_private.hpp"
+
+// There's no async file API, so "prefetching" is reading the next buffer in
+// budget-sized pieces each update while the previous one is used.
+
+static const uint32_t readSize = 0x1000;   // largest single read
+static const uint32_t bufferSize = 0x4000; // double buffered, file size must be a multiple of this
+
+static bool running = false;
+static blit::File file;
+static int updates = 0;
+static uint32_t startTime = 0;
+static uint32_t readOffset = 0;
+static LatencyHistogram updateTimes;
+
+static uint32_t bufferFilled[2];
+static uint32_t bufferOffset[2];
+static int fillBuffer = 0; // the other one is used
+
+const char *getStreamModeName(StreamMode mode)
+{
+    switch(mode)
+    {
+        case StreamMode::Budgeted:
+            return "Budgeted";
+        case StreamMode::DoubleBuffered:
+            return "Double buffered";
+    }
+
+    return "";
+}
+
+static bool fail(const char *message, std::string &error)
+{
+    error = message;
+    cancelStreamTest();
+    return false;
+}
+
+bool updateStreamTest(const char *filename, StreamMode mode, int index, uint32_t seed, uint32_t fileSize, StreamResult &result, std::string &error)
+{
+    auto work = getWorkBuffer();
+    uint8_t *buffers[2] = {work, work + bufferSize};
+
+    uint32_t updateStart = blit::api.get_us_timer();
+    uint32_t budget = streamBudgets[index];
+
+    if(!running)
+    {
+        if(!file.open(filename))
+            return fail("Failed to open test data!", error);
+
+        result = {};
+        updates = 0;
+        startTime = updateStart;
+        readOffset = 0;
+        updateTimes.reset();
+
+        bufferFilled[0] = bufferFilled[1] = 0;
+        fillBuffer = 0;
+
+        running = true;
+    }
+
+    if(mode == StreamMode::Budgeted)
+    {
+        while(getElapsedTime(updateStart, blit::api.get_us_timer()) < budget)
+        {
+            uint32_t len = std::min(readSize, fileSize - readOffset);
+
+            if(file.read(readOffset, len, reinterpret_cast<char *>(work)) != static_cast<int32_t>(len))
+                return fail("Read failed!", error);
+
+            // use it straight away
+            if(!verifyTestData(seed, readOffset, len, work))
+                return fail("Data mismatch!", error);
+
+            result.bytes += len;
+            readOffset = (readOffset + len) % fileSize;
+        }
+    }
+    else
+    {
+        // use the previous buffer if it's ready
+        int useBuffer = !fillBuffer;
+
+        if(bufferFilled[useBuffer] == bufferSize)
+        {
+            if(!verifyTestData(seed, bufferOffset[useBuffer], bufferSize, buffers[useBuffer]))
+                return fail("Data mismatch!", error);
+
+            result.bytes += bufferSize;
+            bufferFilled[useBuffer] = 0;
+        }
+        else if(updates) // nothing to wait for on the first update
+            result.stalls++;
+
+        // then read some more of the next one
+        while(getElapsedTime(updateStart, blit::api.get_us_timer()) < budget)
+        {
+            if(bufferFilled[fillBuffer] == bufferSize)
+            {
+                // can't start another until the other is used
+                if(bufferFilled[!fillBuffer])
+                    break;
+
+                fillBuffer = !fillBuffer;
+            }
+
+            auto &filled = bufferFilled[fillBuffer];
+
+            if(!filled)
+                bufferOffset[fillBuffer] = readOffset;
+
+            uint32_t len = std::min(readSize, bufferSize - filled);
+            auto buf = reinterpret_cast<char *>(buffers[fillBuffer] + filled);
+
+            if(file.read(readOffset, len, buf) != static_cast<int32_t>(len))
+                return fail("Read failed!", error);
+
+            filled += len;
+            readOffset = (readOffset + len) % fileSize;
+        }
+    }
+
+    uint32_t updateEnd = blit::api.get_us_timer();
+    updateTimes.add(getElapsedTime(updateStart, updateEnd));
+
+    if(++updates < streamUpdates)
+        return false;
+
+    result.wallTime = getElapsedTime(startTime, updateEnd);
+    result.medianUpdate = updateTimes.get_percentile(50);
+    result.p99Update = updateTimes.get_percentile(99);
+    result.maxUpdate = updateTimes.get_max();
+
+    file.close();
+    running = false;
+
+    return true;
+}
+
+void cancelStreamTest()
+{
+    file.close();
+    running = false;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+enum class StreamMode {
+    Budgeted = 0,  // read + use as much as fits in the budget
+    DoubleBuffered // prefetch the next buffer while one is used each update
+};
+
+const int numStreamModes = 2;
+
+// us of reading allowed per update
+const int numStreamBudgets = 5;
+const uint32_t streamBudgets[numStreamBudgets] = {500, 1000, 2000, 4000, 8000};
+
+// each budget is run for this many updates
+const int streamUpdates = 200;
+
+struct StreamResult {
+    uint32_t bytes, wallTime;
+    uint32_t medianUpdate, p99Update, maxUpdate;
+    uint32_t stalls; // updates where the next buffer wasn't ready
+};
+
+const char *getStreamModeName(StreamMode mode);
+
+// one update's worth of streaming from filename (looping), returns true after streamUpdates updates
+bool updateStreamTest(const char *filename, StreamMode mode, int index, uint32_t seed, uint32_t fileSize, StreamResult &result, std::string &error);
+
+// abandons a partially finished budget, the next update starts it again
+void cancelStreamTest();
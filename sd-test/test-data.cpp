@@ -0,0 +1,59 @@
+#include "test-data.hpp"
+
+static uint8_t workBuffer[workBufferSize];
+
+// murmur3 finaliser of the word index
+static uint32_t hashWord(uint32_t seed, uint32_t index)
+{
+    uint32_t x = index * 0x9E3779B9 + seed;
+
+    x ^= x >> 16;
+    x *= 0x85EBCA6B;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35;
+    x ^= x >> 16;
+
+    return x;
+}
+
+uint8_t *getWorkBuffer()
+{
+    return workBuffer;
+}
+
+void generateTestData(uint32_t seed, uint32_t offset, uint32_t length, uint8_t *buf)
+{
+    uint32_t word = offset / 4;
+    uint32_t value = hashWord(seed, word);
+
+    for(uint32_t i = 0; i < length; i++, offset++)
+    {
+        if(offset / 4 != word)
+        {
+            word = offset / 4;
+            value = hashWord(seed, word);
+        }
+
+        buf[i] = value >> ((offset % 4) * 8);
+    }
+}
+
+bool verifyTestData(uint32_t seed, uint32_t offset, uint32_t length, const uint8_t *buf)
+{
+    uint32_t word = offset / 4;
+    uint32_t value = hashWord(seed, word);
+
+    for(uint32_t i = 0; i < length; i++, offset++)
+    {
+        if(offset / 4 != word)
+        {
+            word = offset / 4;
+            value = hashWord(seed, word);
+        }
+
+        if(buf[i] != static_cast<uint8_t>(value >> ((offset % 4) * 8)))
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+// Test file contents are a hash of (seed, offset), so any range of a file of
+// any size can be generated or checked without keeping the file in memory.
+
+// largest single read/write, all the tests share this buffer
+const uint32_t workBufferSize = 0x10000;
+
+uint8_t *getWorkBuffer();
+
+void generateTestData(uint32_t seed, uint32_t offset, uint32_t length, uint8_t *buf);
+
+bool verifyTestData(uint32_t seed, uint32_t offset, uint32_t length, const uint8_t *buf);
@@ -0,0 +1,130 @@
+#include <algorithm>
+
+#include "write-test.hpp"
+#include "stats.hpp"
+#include "test-data.hpp"
+
+#include "32blit.hpp"
+#include "engine/api_private.hpp"
+
+static LatencyHistogram latency;
+
+const char *getWriteModeName(WriteMode mode)
+{
+    switch(mode)
+    {
+        case WriteMode::Append:
+            return "Append";
+        case WriteMode::Overwrite:
+            return "Overwrite";
+        case WriteMode::Mixed:
+            return "Mixed read/write";
+    }
+
+    return "";
+}
+
+static bool verifyFile(const char *filename, uint32_t seed, uint32_t fileSize, std::string &error)
+{
+    blit::File f(filename);
+    auto buf = getWorkBuffer();
+
+    if(f.get_length() != fileSize)
+    {
+        error = "Written file has wrong size!";
+        return false;
+    }
+
+    for(uint32_t offset = 0; offset < fileSize; offset += workBufferSize)
+    {
+        uint32_t len = std::min(fileSize - offset, workBufferSize);
+
+        if(f.read(offset, len, reinterpret_cast<char *>(buf)) != static_cast<int32_t>(len) || !verifyTestData(seed, offset, len, buf))
+        {
+            error = "Written data mismatch!";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool runWriteTest(const char *filename, WriteMode mode, uint32_t chunkSize, uint32_t seed, uint32_t fileSize, WriteResult &result, std::string &error)
+{
+    blit::File f;
+    auto buf = getWorkBuffer();
+
+    // write-only truncates, read|write keeps the existing contents
+    int openMode = mode == WriteMode::Append ? blit::OpenMode::write : blit::OpenMode::read | blit::OpenMode::write;
+
+    uint32_t start = blit::api.get_us_timer();
+    bool opened = f.open(filename, openMode);
+    result.openTime = getElapsedTime(start, blit::api.get_us_timer());
+
+    if(!opened)
+    {
+        error = "Failed to open file for writing!";
+        return false;
+    }
+
+    latency.reset();
+    result.writeTime = result.readTime = 0;
+
+    uint32_t count = fileSize / chunkSize;
+
+    for(uint32_t j = 0; j < count; j++)
+    {
+        uint32_t offset = j * chunkSize;
+
+        generateTestData(seed, offset, chunkSize, buf);
+
+        start = blit::api.get_us_timer();
+        auto written = f.write(offset, chunkSize, reinterpret_cast<const char *>(buf));
+        uint32_t time = getElapsedTime(start, blit::api.get_us_timer());
+
+        if(written != static_cast<int32_t>(chunkSize))
+        {
+            error = "Write failed!";
+            return false;
+        }
+
+        result.writeTime += time;
+        latency.add(time);
+
+        if(mode != WriteMode::Mixed)
+            continue;
+
+        // the rest of the file already has the same data, so anywhere is valid
+        uint32_t readOffset = blit::random() % (fileSize - chunkSize + 1);
+
+        start = blit::api.get_us_timer();
+        auto read = f.read(readOffset, chunkSize, reinterpret_cast<char *>(buf));
+        time = getElapsedTime(start, blit::api.get_us_timer());
+
+        if(read != static_cast<int32_t>(chunkSize))
+        {
+            error = "Read failed!";
+            return false;
+        }
+
+        result.readTime += time;
+        latency.add(time);
+
+        if(!verifyTestData(seed, readOffset, chunkSize, buf))
+        {
+            error = "Data mismatch!";
+            return false;
+        }
+    }
+
+    // closing is what flushes
+    start = blit::api.get_us_timer();
+    f.close();
+    result.closeTime = getElapsedTime(start, blit::api.get_us_timer());
+
+    result.minLatency = latency.get_min();
+    result.medianLatency = latency.get_percentile(50);
+    result.p99Latency = latency.get_percentile(99);
+
+    return verifyFile(filename, seed, fileSize, error);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+enum class WriteMode {
+    Append = 0, // new file
+    Overwrite,  // existing file, in place
+    Mixed       // overwrite interleaved with random reads
+};
+
+const int numWriteModes = 3;
+
+struct WriteResult {
+    uint32_t openTime, writeTime, readTime, closeTime;
+    uint32_t minLatency, medianLatency, p99Latency;
+};
+
+const char *getWriteModeName(WriteMode mode);
+
+// writes fileSize bytes of test data for seed in chunkSize writes, then reads it back to check
+// Overwrite/Mixed expect filename to already contain the same data
+bool runWriteTest(const char *filename, WriteMode mode, uint32_t chunkSize, uint32_t seed, uint32_t fileSize, WriteResult &result, std::string &error);
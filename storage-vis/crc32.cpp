@@ -0,0 +1,54 @@
+#include <cstring>
+
+#include "crc32.hpp"
+
+static uint32_t crc_tables[8][256];
+
+static void init_crc_tables() {
+  for(uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for(int j = 0; j < 8; j++)
+      c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+
+    crc_tables[0][i] = c;
+  }
+
+  // tables for the byte 1-7 positions back
+  for(int i = 0; i < 256; i++) {
+    for(int t = 1; t < 8; t++)
+      crc_tables[t][i] = (crc_tables[t - 1][i] >> 8) ^ crc_tables[0][crc_tables[t - 1][i] & 0xFF];
+  }
+}
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, uint32_t len) {
+  if(!crc_tables[0][1])
+    init_crc_tables();
+
+  crc = ~crc;
+
+  // slice-by-8, assumes little endian
+  while(len >= 8) {
+    uint32_t one, two;
+    memcpy(&one, data, 4);
+    memcpy(&two, data + 4, 4);
+
+    one ^= crc;
+
+    crc = crc_tables[7][one & 0xFF] ^ crc_tables[6][(one >> 8) & 0xFF] ^ crc_tables[5][(one >> 16) & 0xFF] ^ crc_tables[4][one >> 24]
+        ^ crc_tables[3][two & 0xFF] ^ crc_tables[2][(two >> 8) & 0xFF] ^ crc_tables[1][(two >> 16) & 0xFF] ^ crc_tables[0][two >> 24];
+
+    data += 8;
+    len -= 8;
+  }
+
+  while(len--)
+    crc = crc_tables[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+
+  return ~crc;
+}
+
+bool crc32_self_test() {
+  // long enough to go through the slice-by-8 loop, and the byte loop for the last one
+  auto data = reinterpret_cast<const uint8_t *>("123456789");
+  return crc32_update(0, data, 9) == 0xCBF43926;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Standard (zlib) CRC32, eight bytes at a time. Pass the previous result to
+// continue a CRC across calls, starting from 0.
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, uint32_t len);
+
+// checks the standard "123456789" test vector
+bool crc32_self_test();
@@ -0,0 +1,176 @@
+#include <algorithm>
+
+#include "defrag.hpp"
+
+static int get_gap_bucket(unsigned size) {
+  int bucket = 0;
+  while(size > 1 && bucket < num_gap_buckets - 1) {
+    size >>= 1;
+    bucket++;
+  }
+
+  return bucket;
+}
+
+FragStats analyse_fragmentation(const std::vector<UsedRange> &used, unsigned num_blocks) {
+  FragStats stats = {};
+
+  auto add_gap = [&stats](unsigned size) {
+    if(!size)
+      return;
+
+    stats.free_blocks += size;
+    stats.largest_free = std::max(stats.largest_free, size);
+    stats.num_gaps++;
+    stats.gap_histogram[get_gap_bucket(size)]++;
+  };
+
+  unsigned last_end = 0;
+
+  for(auto &range : used) {
+    add_gap(range.start - last_end);
+    last_end = range.start + range.count;
+  }
+
+  add_gap(num_blocks - last_end);
+
+  if(stats.free_blocks)
+    stats.frag_index = 1.0f - float(stats.largest_free) / stats.free_blocks;
+
+  return stats;
+}
+
+// slide everything after the first gap down
+static CompactionPlan plan_slide(const std::vector<UsedRange> &used) {
+  CompactionPlan plan = {};
+  uint32_t pos = 0;
+
+  for(unsigned i = 0; i < used.size(); i++) {
+    auto &range = used[i];
+
+    if(range.start != pos) {
+      plan.moves.push_back({int(i), range.start, pos, range.count});
+      plan.blocks_to_copy += range.count;
+    }
+
+    pos += range.count;
+  }
+
+  return plan;
+}
+
+// move the last entries into the first gaps they fit in, only works if there are gaps in the right places
+static bool plan_fill(const std::vector<UsedRange> &used, CompactionPlan &plan) {
+  plan = {};
+
+  unsigned total_used = 0;
+  for(auto &range : used)
+    total_used += range.count;
+
+  auto ranges = used;
+  std::vector<int> order(used.size()); // indices sorted by current start
+  for(unsigned i = 0; i < order.size(); i++)
+    order[i] = i;
+
+  while(!order.empty()) {
+    // find the first gap
+    unsigned first_gap = 0;
+    for(auto i : order) {
+      if(ranges[i].start != first_gap)
+        break;
+      first_gap += ranges[i].count;
+    }
+
+    // everything is packed
+    if(first_gap >= total_used)
+      return true;
+
+    // try to move the last range into a gap below it
+    int last = order.back();
+    auto &range = ranges[last];
+
+    unsigned gap_start = 0;
+    int found = -1;
+
+    for(unsigned j = 0; j < order.size() - 1; j++) {
+      auto &other = ranges[order[j]];
+
+      if(other.start - gap_start >= range.count) {
+        found = j;
+        break;
+      }
+
+      gap_start = other.start + other.count;
+    }
+
+    // no gap before the last range is big enough
+    if(found < 0)
+      return false;
+
+    plan.moves.push_back({last, range.start, gap_start, range.count});
+    plan.blocks_to_copy += range.count;
+
+    range.start = gap_start;
+
+    // keep the order sorted by start
+    order.pop_back();
+    order.insert(order.begin() + found, last);
+  }
+
+  return true;
+}
+
+CompactionPlan plan_compaction(const std::vector<UsedRange> &used) {
+  auto plan = plan_slide(used);
+
+  // filling gaps with entries from the end can copy a lot less
+  CompactionPlan fill_plan;
+  if(plan_fill(used, fill_plan) && fill_plan.blocks_to_copy < plan.blocks_to_copy)
+    return fill_plan;
+
+  return plan;
+}
+
+bool simulate_compaction(const std::vector<UsedRange> &used, unsigned num_blocks, const CompactionPlan &plan, std::vector<UsedRange> &result) {
+  std::vector<int> owner(num_blocks, -1);
+
+  for(unsigned i = 0; i < used.size(); i++) {
+    for(unsigned b = used[i].start; b < unsigned(used[i].start + used[i].count); b++)
+      owner[b] = i;
+  }
+
+  result = used;
+
+  for(auto &move : plan.moves) {
+    if(move.range < 0 || move.range >= int(result.size()))
+      return false;
+
+    auto &range = result[move.range];
+
+    if(range.start != move.from || range.count != move.count || move.to + move.count > num_blocks)
+      return false;
+
+    // free the source first, sliding down can overlap itself
+    for(unsigned b = move.from; b < unsigned(move.from + move.count); b++)
+      owner[b] = -1;
+
+    for(unsigned b = move.to; b < unsigned(move.to + move.count); b++) {
+      if(owner[b] != -1)
+        return false;
+
+      owner[b] = move.range;
+    }
+
+    range.start = move.to;
+  }
+
+  // everything should still be in one piece
+  for(unsigned i = 0; i < result.size(); i++) {
+    for(unsigned b = result[i].start; b < unsigned(result[i].start + result[i].count); b++) {
+      if(owner[b] != int(i))
+        return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Fragmentation stats and compaction planning for the flash layout. Works on
+// a list of used block ranges so plans can be tried out without touching flash.
+
+struct UsedRange {
+  uint32_t start, count;
+};
+
+static const int num_gap_buckets = 6; // 1, 2-3, 4-7, 8-15, 16-31, 32+ blocks
+
+struct FragStats {
+  unsigned free_blocks, largest_free, num_gaps;
+  float frag_index; // 0 if the free space is one run, towards 1 as it gets split up
+  unsigned gap_histogram[num_gap_buckets];
+};
+
+struct CompactionMove {
+  int range; // index in the used ranges
+  uint32_t from, to, count;
+};
+
+struct CompactionPlan {
+  std::vector<CompactionMove> moves;
+  unsigned blocks_to_copy;
+};
+
+// used ranges are sorted by start block
+FragStats analyse_fragmentation(const std::vector<UsedRange> &used, unsigned num_blocks);
+
+// moves to get all the free space into one run at the end
+CompactionPlan plan_compaction(const std::vector<UsedRange> &used);
+
+// applies the plan to a model of the layout, fails if a move would overwrite anything
+// result is in the same order as used
+bool simulate_compaction(const std::vector<UsedRange> &used, unsigned num_blocks, const CompactionPlan &plan, std::vector<UsedRange> &result);
@@ -0,0 +1,80 @@
+#include <algorithm>
+
+#include "icon-cache.hpp"
+
+#include "engine/engine.hpp"
+
+IconCache::IconCache(unsigned max_icons) : max_icons(max_icons) {
+  icons.reserve(max_icons);
+}
+
+IconCache::~IconCache() {
+  for(auto &icon : icons)
+    free_surface(icon.surface);
+}
+
+blit::Surface *IconCache::get(const blit::packed_image *image) {
+  for(auto &icon : icons) {
+    if(icon.image == image) {
+      icon.last_used = ++use_counter;
+      return icon.surface;
+    }
+  }
+
+  auto surface = decode(image);
+
+  if(!surface)
+    return nullptr;
+
+  bytes_used += get_surface_size(surface);
+
+  if(is_full()) {
+    // replace the least recently used
+    auto lru = std::min_element(icons.begin(), icons.end(), [](const Icon &a, const Icon &b) {return a.last_used < b.last_used;});
+
+    bytes_used -= get_surface_size(lru->surface);
+    free_surface(lru->surface);
+
+    *lru = {image, surface, ++use_counter};
+  } else
+    icons.push_back({image, surface, ++use_counter});
+
+  return surface;
+}
+
+blit::Surface *IconCache::find(const blit::packed_image *image) const {
+  for(auto &icon : icons) {
+    if(icon.image == image)
+      return icon.surface;
+  }
+
+  return nullptr;
+}
+
+blit::Surface *IconCache::decode(const blit::packed_image *image) {
+  auto start = blit::now_us();
+
+  auto surface = blit::Surface::load(image);
+
+  decode_us += blit::us_diff(start, blit::now_us());
+  num_decoded++;
+
+  return surface;
+}
+
+void IconCache::free_surface(blit::Surface *surface) {
+  delete[] surface->data;
+  delete[] surface->palette;
+  delete surface;
+}
+
+uint32_t IconCache::get_surface_size(const blit::Surface *surface) {
+  uint32_t size = sizeof(blit::Surface);
+
+  if(surface->format == blit::PixelFormat::P)
+    size += surface->bounds.w * surface->bounds.h + 256 * sizeof(blit::Pen); // Surface::load always allocates a full palette
+  else
+    size += surface->bounds.w * surface->bounds.h * 4;
+
+  return size;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "graphics/surface.hpp"
+
+// Decoded game icons, loaded the first time they're asked for. Only a few are
+// kept, the least recently used one is freed to make space.
+
+class IconCache final {
+public:
+  IconCache(unsigned max_icons);
+  ~IconCache();
+
+  // loads the icon if it isn't already
+  blit::Surface *get(const blit::packed_image *image);
+
+  // nullptr if not loaded, doesn't count as a use
+  blit::Surface *find(const blit::packed_image *image) const;
+
+  bool is_full() const {return icons.size() == max_icons;}
+
+  // decode without caching (timed with the rest), free it after
+  blit::Surface *decode(const blit::packed_image *image);
+  static void free_surface(blit::Surface *surface);
+
+  // approximate, includes the palette
+  static uint32_t get_surface_size(const blit::Surface *surface);
+
+  unsigned get_num_loaded() const {return icons.size();}
+  uint32_t get_bytes_used() const {return bytes_used;}
+
+  unsigned get_num_decoded() const {return num_decoded;}
+  uint32_t get_decode_us() const {return decode_us;}
+
+private:
+  struct Icon {
+    const blit::packed_image *image;
+    blit::Surface *surface;
+    uint32_t last_used;
+  };
+
+  unsigned max_icons;
+  std::vector<Icon> icons; // not many, so just searched
+
+  uint32_t use_counter = 0;
+  uint32_t bytes_used = 0;
+
+  unsigned num_decoded = 0;
+  uint32_t decode_us = 0;
+};
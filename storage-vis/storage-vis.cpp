@@ -1,21 +1,36 @@
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
-#include <list>
+#include <new>
+#include <string>
+#include <vector>
 
 #include "32blit.hpp"
 
 #include "engine/api_private.hpp"
 
-// hardcoded consts...
+#include "crc32.hpp"
+#include "defrag.hpp"
+#include "icon-cache.hpp"
+
+// defaults for anything we can't work out from the installed games
 // 32MB flash - 4MB reserved
-static const uint32_t storage_size = (32 - 4) * 1024 * 1024;
-static const uint32_t storage_block_size = 64 * 1024;
-static const uint32_t storage_size_blocks = storage_size / storage_block_size;
+static const uint32_t default_storage_size = (32 - 4) * 1024 * 1024;
+static const uint32_t default_block_size = 64 * 1024;
 
-static const int num_cols = 32;
-static const int num_rows = storage_size_blocks / num_cols;
 static const int block_tile_size = 8;
 static const int block_tile_border = 1;
 
+static const unsigned max_icons = 24;
+static const uint32_t colour_slice_us = 1000;
+static const uint32_t verify_slice_us = 4000;
+static const uint32_t verify_chunk_size = 16 * 1024; // time is checked between chunks
+static const char *saved_crc_filename = "storage-vis-crc.txt";
+
+static const int grid_y = 10;
+static const int render_average_frames = 50;
+static const int info_height = 95; // space below the grid for the text
+
 // from launcher-shared
 struct BlitGameHeader {
   uint32_t magic;
@@ -52,13 +67,104 @@ struct RawTypeMetadata {
 
 // game/space list
 struct StorageEntry {
-  uint16_t start_block;
+  uint32_t start_block, num_blocks;
   const RawMetadata *metadata; // nullptr == empty
-  blit::Surface *icon;
+  int game; // index in installed_games, -1 if empty
 };
 
-static std::list<StorageEntry> storage_usage;
-static std::list<StorageEntry>::iterator selected_entry;
+// a block, or a group of blocks if there are too many to fit on screen
+struct GridTile {
+  uint32_t owner; // index in entries, the one using the most of the tile
+  uint32_t owner_blocks, used_blocks;
+};
+
+enum class VerifyResult : uint8_t {
+  Unchecked,
+  Saved, // first check of a game with nothing to compare to, CRC saved for next time
+  OK,
+  Bad,
+};
+
+struct InstalledGame {
+  const uint8_t *ptr;
+  uint32_t block, size;
+  const RawMetadata *metadata;
+  const blit::packed_image *icon_data;
+
+  blit::Pen colour; // from the icon, set when it's first loaded
+  bool has_colour;
+
+  uint32_t bin_size; // the part the CRC covers
+  VerifyResult verify_result;
+  uint32_t saved_crc; // of the flash contents, from an earlier check
+  bool has_saved_crc;
+};
+
+static const uint32_t no_owner = ~0u;
+
+struct StorageLayout {
+  std::vector<StorageEntry> entries;
+  std::vector<GridTile> tiles;
+};
+
+static struct {
+  uint32_t block_size = default_block_size;
+  uint32_t num_blocks = default_storage_size / default_block_size;
+} geometry;
+
+static struct {
+  int cols = 0, rows = 0;
+  int x = 0;
+  uint32_t blocks_per_tile = 1;
+  uint32_t num_tiles = 0;
+} grid;
+
+static std::vector<InstalledGame> installed_games;
+static IconCache icon_cache(max_icons);
+static unsigned next_colour_game = 0; // colours are filled in a few at a time
+static unsigned num_game_icons = 0;
+static uint32_t init_us = 0;
+
+// CRC checking
+static bool verifying = false, verify_done = false;
+static bool crc_self_test_failed = false;
+static unsigned verify_game = 0;
+static uint32_t verify_offset = 0, verify_crc = 0;
+static uint64_t verify_bytes = 0; // total across all games, for the speed
+static uint64_t verify_us = 0;
+static unsigned num_verified = 0, num_bad = 0, num_saved = 0;
+static bool saved_crcs_stale = false; // file has entries for games that are gone
+static bool crc_save_failed = false;
+
+static StorageLayout storage_usage;
+static int selected_entry = 0;
+
+// layout after the planned compaction
+static StorageLayout sim_usage;
+static std::vector<int> sim_source; // index in storage_usage, -1 for empty
+static bool show_simulated = false;
+
+// the grid is drawn once, then only the entries that change are redrawn
+// it's paletted as it's only flat colours, the icons are drawn on top after
+static const blit::Pen background_colour(20, 30, 40);
+static blit::Surface *grid_surface = nullptr;
+static blit::Pen grid_palette[256];
+static int grid_palette_size = 0;
+static bool grid_palette_full = false;
+static bool grid_dirty = true;
+static std::vector<int> dirty_entries;
+// rows that have changed since they were last copied to the screen, counted
+// down each frame. Copied twice in case the screen is double buffered
+static const uint8_t grid_copy_frames = 2;
+static std::vector<uint8_t> grid_rows_to_copy;
+static bool retained_render = true; // the old way for comparison
+
+static uint32_t render_us_total = 0, render_us_avg = 0;
+static int render_frames = 0;
+
+static FragStats frag_stats;
+static CompactionPlan compaction_plan;
+static bool simulation_ok = false;
 
 static const RawMetadata placeholder_meta {
   0,
@@ -69,24 +175,131 @@ static const RawMetadata placeholder_meta {
   "UNKNOWN"
 };
 
-static uint16_t calc_num_blocks(uint32_t size) {
-  return (size - 1) / storage_block_size + 1;
+static uint32_t calc_num_blocks(uint32_t size) {
+  return (size - 1) / geometry.block_size + 1;
+}
+
+// there's no API for the flash size, but the games are memory mapped so the
+// distance between two of them gives the block size
+static void detect_geometry(const std::vector<InstalledGame> &games) {
+  for(size_t i = 1; i < games.size(); i++) {
+    auto block_diff = games[i].block - games[i - 1].block;
+    auto ptr_diff = uint32_t(games[i].ptr - games[i - 1].ptr);
+
+    if(block_diff && ptr_diff % block_diff == 0) {
+      auto block_size = ptr_diff / block_diff;
+
+      // should be a power of two
+      if(block_size && !(block_size & (block_size - 1))) {
+        geometry.block_size = block_size;
+        break;
+      }
+    }
+  }
+
+  // at least big enough for everything installed
+  geometry.num_blocks = default_storage_size / geometry.block_size;
+
+  for(auto &game : games)
+    geometry.num_blocks = std::max(geometry.num_blocks, game.block + calc_num_blocks(game.size));
+}
+
+// fit as many tiles as we can, then start putting more blocks in each one
+static void calc_grid() {
+  auto size_with_border = block_tile_size + block_tile_border;
+
+  int max_cols = (blit::screen.bounds.w - 20) / size_with_border;
+  int max_rows = (blit::screen.bounds.h - grid_y - info_height) / size_with_border;
+
+  // prefer a power of two, easier to count
+  grid.cols = 1;
+  while(grid.cols * 2 <= max_cols)
+    grid.cols *= 2;
+
+  if(geometry.num_blocks > uint32_t(grid.cols * max_rows))
+    grid.cols = max_cols;
+
+  uint32_t max_tiles = grid.cols * max_rows;
+
+  grid.blocks_per_tile = (geometry.num_blocks - 1) / max_tiles + 1;
+  grid.num_tiles = (geometry.num_blocks - 1) / grid.blocks_per_tile + 1;
+  grid.rows = (grid.num_tiles - 1) / grid.cols + 1;
+
+  grid.x = (blit::screen.bounds.w - (grid.cols * size_with_border)) / 2;
+}
+
+static void create_grid_surface() {
+  auto size_with_border = block_tile_size + block_tile_border;
+
+  // space for the borders around the first row/column
+  blit::Size size(grid.cols * size_with_border + 1, grid.rows * size_with_border + 1);
+
+  auto data = new(std::nothrow) uint8_t[size.w * size.h];
+
+  // draw straight to the screen instead
+  if(!data)
+    return;
+
+  grid_surface = new blit::Surface(data, blit::PixelFormat::P, size);
+  grid_surface->palette = grid_palette;
+  grid_dirty = true;
 }
 
-static blit::Pen get_entry_colour(StorageEntry &entry) {
+static void free_grid_surface() {
+  delete[] grid_surface->data;
+  delete grid_surface;
+  grid_surface = nullptr;
+}
+
+// sets the pen by palette index if drawing to the grid surface
+static void set_pen(blit::Surface &dest, blit::Pen colour) {
+  if(dest.format != blit::PixelFormat::P) {
+    dest.pen = colour;
+    return;
+  }
+
+  int index = 0;
+  while(index < grid_palette_size && (grid_palette[index].r != colour.r || grid_palette[index].g != colour.g || grid_palette[index].b != colour.b))
+    index++;
+
+  if(index == grid_palette_size) {
+    // more colours than there's space for (hundreds of games)
+    if(grid_palette_size == 256) {
+      grid_palette_full = true;
+      index = 0;
+    } else
+      grid_palette[grid_palette_size++] = colour;
+  }
+
+  dest.pen = blit::Pen(index);
+}
+
+static blit::Pen get_entry_colour(const StorageEntry &entry) {
   if(!entry.metadata)
     return {100, 100, 100}; // empty
 
-  if(!entry.icon)
-    return {255, 255, 255}; // no metadata/icon
+  if(entry.game < 0)
+    return {255, 255, 255};
+
+  auto &game = installed_games[entry.game];
+
+  if(game.verify_result == VerifyResult::Bad)
+    return {255, 0, 0};
+
+  if(!game.has_colour)
+    return {255, 255, 255}; // no metadata/icon, or not loaded yet
+
+  return game.colour;
+}
 
+static blit::Pen calc_icon_colour(blit::Surface *icon) {
   // average the icon pixels (it's only 8x8)
-  float r = 0.0f, g = 0.0f, b = 0.0f;
+  int r = 0, g = 0, b = 0;
   int c = 0;
 
-  for(int y = 0; y < entry.icon->bounds.h; y++) {
-    for(int x = 0; x < entry.icon->bounds.w; x++) {
-      auto tmp = entry.icon->get_pixel({x, y});
+  for(int y = 0; y < icon->bounds.h; y++) {
+    for(int x = 0; x < icon->bounds.w; x++) {
+      auto tmp = icon->get_pixel({x, y});
       if(tmp.a) {
         r += tmp.r;
         g += tmp.g;
@@ -96,18 +309,310 @@ static blit::Pen get_entry_colour(StorageEntry &entry) {
     }
   }
 
-  return {uint8_t(r / c), uint8_t(g / c), uint8_t(b / c)};
+  if(!c)
+    return {255, 255, 255};
+
+  return {r / c, g / c, b / c};
+}
+
+static blit::Surface *load_icon(InstalledGame &game) {
+  if(!game.icon_data)
+    return nullptr;
+
+  auto icon = icon_cache.get(game.icon_data);
+
+  if(icon && !game.has_colour) {
+    game.colour = calc_icon_colour(icon);
+    game.has_colour = true;
+    grid_dirty = true;
+  }
+
+  return icon;
+}
+
+// the grid needs every colour, but not every icon
+static void update_colours(uint32_t budget_us) {
+  auto start = blit::now_us();
+  auto first_game = next_colour_game;
+
+  while(next_colour_game < installed_games.size() && blit::us_diff(start, blit::now_us()) < budget_us) {
+    auto &game = installed_games[next_colour_game++];
+
+    if(game.has_colour)
+      continue;
+
+    // keep the icon if there's space, it'll be drawn
+    if(!icon_cache.is_full()) {
+      load_icon(game);
+      continue;
+    }
+
+    auto icon = icon_cache.decode(game.icon_data);
+
+    if(icon) {
+      game.colour = calc_icon_colour(icon);
+      game.has_colour = true;
+      IconCache::free_surface(icon);
+    }
+  }
+
+  if(next_colour_game != first_game)
+    grid_dirty = true;
+}
+
+// the CRC in the metadata is for the file as built. Relocatable games have
+// their addresses patched when they're flashed and the relocation list isn't
+// kept, so only games at the start of flash (relocated by 0) still match it.
+// For the rest the CRC of what's in flash is saved on the first check
+static bool has_build_crc(const InstalledGame &game) {
+  return game.metadata != &placeholder_meta && game.block == 0;
+}
+
+// one "block,build crc,flash crc,title" line per game, the build CRC is there
+// so that installing a different version in the same place isn't a mismatch
+static void load_saved_crcs() {
+  for(auto &game : installed_games)
+    game.has_saved_crc = false;
+
+  saved_crcs_stale = false;
+
+  blit::File f(saved_crc_filename);
+
+  if(!f.is_open())
+    return;
+
+  std::string in(f.get_length(), '\0');
+
+  if(f.read(0, in.length(), &in[0]) != int32_t(in.length()))
+    return;
+
+  size_t line_start = 0;
+
+  while(line_start < in.length()) {
+    auto line_end = in.find('\n', line_start);
+    if(line_end == std::string::npos)
+      line_end = in.length();
+
+    auto line = in.substr(line_start, line_end - line_start);
+    line_start = line_end + 1;
+
+    char *end;
+    uint32_t block = strtoul(line.c_str(), &end, 10);
+
+    if(*end != ',')
+      continue;
+
+    uint32_t build_crc = strtoul(end + 1, &end, 16);
+
+    if(*end != ',')
+      continue;
+
+    uint32_t flash_crc = strtoul(end + 1, &end, 16);
+
+    if(*end != ',')
+      continue;
+
+    std::string title(end + 1);
+
+    if(!title.empty() && title.back() == '\r')
+      title.pop_back();
+
+    auto game = std::find_if(installed_games.begin(), installed_games.end(), [&](const InstalledGame &game) {
+      return game.block == block && game.metadata->crc32 == build_crc && title == game.metadata->title;
+    });
+
+    if(game == installed_games.end() || has_build_crc(*game)) {
+      saved_crcs_stale = true;
+      continue;
+    }
+
+    game->saved_crc = flash_crc;
+    game->has_saved_crc = true;
+  }
+}
+
+static bool write_saved_crcs() {
+  std::string out;
+  char buf[64];
+
+  for(auto &game : installed_games) {
+    if(!game.has_saved_crc)
+      continue;
+
+    snprintf(buf, sizeof(buf), "%u,%08X,%08X,", unsigned(game.block), unsigned(game.metadata->crc32), unsigned(game.saved_crc));
+    out += buf;
+    out += game.metadata->title;
+    out += "\n";
+  }
+
+  blit::File f(saved_crc_filename, blit::OpenMode::write);
+
+  return f.write(0, out.length(), out.data()) == int32_t(out.length());
+}
+
+static void start_verify() {
+  if(!crc32_self_test()) {
+    crc_self_test_failed = true;
+    return;
+  }
+
+  for(auto &game : installed_games)
+    game.verify_result = VerifyResult::Unchecked;
+
+  load_saved_crcs();
+
+  // clear any old mismatches
+  if(num_bad)
+    grid_dirty = true;
+
+  verifying = true;
+  crc_save_failed = false;
+  verify_game = 0;
+  verify_offset = verify_crc = 0;
+  verify_bytes = verify_us = 0;
+  num_verified = num_bad = num_saved = 0;
+}
+
+// checks each game's CRC against its metadata or the saved one, stopping after the time budget
+static void update_verify(uint32_t budget_us) {
+  auto start = blit::now_us();
+
+  while(verify_game < installed_games.size() && blit::us_diff(start, blit::now_us()) < budget_us) {
+    auto &game = installed_games[verify_game];
+
+    // the games are memory mapped, so this is just reading flash
+    uint32_t len = std::min(verify_chunk_size, game.bin_size - verify_offset);
+    verify_crc = crc32_update(verify_crc, game.ptr + verify_offset, len);
+    verify_offset += len;
+    verify_bytes += len;
+
+    if(verify_offset == game.bin_size) {
+      if(has_build_crc(game) || game.has_saved_crc) {
+        auto expected_crc = has_build_crc(game) ? game.metadata->crc32 : game.saved_crc;
+        game.verify_result = verify_crc == expected_crc ? VerifyResult::OK : VerifyResult::Bad;
+        num_verified++;
+      } else {
+        game.verify_result = VerifyResult::Saved;
+        game.saved_crc = verify_crc;
+        game.has_saved_crc = true;
+        num_saved++;
+      }
+
+      if(game.verify_result == VerifyResult::Bad) {
+        num_bad++;
+        grid_dirty = true;
+      }
+
+      verify_game++;
+      verify_offset = verify_crc = 0;
+    }
+  }
+
+  verify_us += blit::us_diff(start, blit::now_us());
+
+  if(verify_game == installed_games.size()) {
+    verifying = false;
+    verify_done = true;
+
+    // a bad game keeps the CRC it had before
+    if(num_saved || saved_crcs_stale)
+      crc_save_failed = !write_saved_crcs();
+  }
+}
+
+static void add_entry(StorageLayout &layout, uint32_t start_block, uint32_t end_block, const RawMetadata *metadata, int game) {
+  StorageEntry entry = {start_block, end_block - start_block, metadata, game};
+
+  if(layout.tiles.empty())
+    layout.tiles.resize(grid.num_tiles, {no_owner, 0, 0});
+
+  // tiles this entry covers, only the first and last can be partial
+  uint32_t index = layout.entries.size();
+
+  for(auto tile = start_block / grid.blocks_per_tile; tile <= (end_block - 1) / grid.blocks_per_tile; tile++) {
+    auto tile_start = tile * grid.blocks_per_tile;
+    auto count = std::min(tile_start + grid.blocks_per_tile, end_block) - std::max(tile_start, start_block);
+
+    auto &grid_tile = layout.tiles[tile];
+
+    // empty space only owns a tile if nothing else is in it
+    if(grid_tile.owner == no_owner || (metadata && count > grid_tile.owner_blocks)) {
+      grid_tile.owner = index;
+      grid_tile.owner_blocks = metadata ? count : 0;
+    }
+
+    if(metadata)
+      grid_tile.used_blocks += count;
+  }
+
+  layout.entries.push_back(entry);
+}
+
+static void plan_defrag() {
+  std::vector<UsedRange> used;
+  std::vector<int> used_entries;
+
+  for(unsigned i = 0; i < storage_usage.entries.size(); i++) {
+    auto &entry = storage_usage.entries[i];
+    if(entry.metadata) {
+      used.push_back({entry.start_block, entry.num_blocks});
+      used_entries.push_back(i);
+    }
+  }
+
+  frag_stats = analyse_fragmentation(used, geometry.num_blocks);
+  compaction_plan = plan_compaction(used);
+
+  std::vector<UsedRange> result;
+  simulation_ok = simulate_compaction(used, geometry.num_blocks, compaction_plan, result);
+
+  sim_usage = {};
+  sim_source.clear();
+
+  if(!simulation_ok)
+    return;
+
+  // rebuild the layout in the new order
+  std::vector<int> order(result.size());
+  for(unsigned i = 0; i < order.size(); i++)
+    order[i] = i;
+
+  std::sort(order.begin(), order.end(), [&result](int a, int b) {return result[a].start < result[b].start;});
+
+  uint32_t last_end = 0;
+
+  for(auto i : order) {
+    auto &range = result[i];
+    auto &entry = storage_usage.entries[used_entries[i]];
+
+    if(last_end != range.start) {
+      add_entry(sim_usage, last_end, range.start, nullptr, -1);
+      sim_source.push_back(-1);
+    }
+
+    add_entry(sim_usage, range.start, range.start + range.count, entry.metadata, entry.game);
+    sim_source.push_back(used_entries[i]);
+
+    last_end = range.start + range.count;
+  }
+
+  if(last_end != geometry.num_blocks) {
+    add_entry(sim_usage, last_end, geometry.num_blocks, nullptr, -1);
+    sim_source.push_back(-1);
+  }
 }
 
 void init() {
+  auto start = blit::now_us();
+
   blit::set_screen_mode(blit::ScreenMode::hires);
 
-  uint16_t last_end = 0;
+  auto &games = installed_games;
 
-  blit::api.list_installed_games([&last_end](const uint8_t *ptr, uint32_t block, uint32_t size) {
+  blit::api.list_installed_games([&](const uint8_t *ptr, uint32_t block, uint32_t size) {
 
     // go back to find the metadata
-    uint32_t header_size = ((BlitGameHeader *)ptr)->end & 0x1FFFFFF;
+    uint32_t header_size = ((BlitGameHeader *)ptr)->end & 0x1FFFFFF; // also the size of the binary
     auto meta_ptr = ptr + header_size;
 
     const RawMetadata *metadata = nullptr;
@@ -133,72 +638,72 @@ void init() {
     else
       metadata = &placeholder_meta; // to distinguish from empty space
 
-    // setup new entry
-    uint16_t block16 = block;
-    uint16_t end_block = block16 + calc_num_blocks(size);
+    // icons are loaded later
+    games.push_back({ptr, block, size, metadata, icon_data, {255, 255, 255}, icon_data == nullptr, header_size, VerifyResult::Unchecked, 0, false});
 
-    auto icon = icon_data ? blit::Surface::load(icon_data) : nullptr;
+    if(icon_data)
+      num_game_icons++;
+  });
 
-    StorageEntry new_entry = {block16, metadata, icon};
+  detect_geometry(games);
 
-    if(last_end != block) {
-      // insert empty space
-      StorageEntry empty_entry = {last_end, nullptr, nullptr};
-      storage_usage.emplace_back(empty_entry);
-    }
+  calc_grid();
 
-    storage_usage.emplace_back(new_entry);
+  uint32_t last_end = 0;
 
-    last_end = end_block;
-  });
+  for(unsigned i = 0; i < games.size(); i++) {
+    auto &game = games[i];
+
+    // setup new entry
+    uint32_t end_block = game.block + calc_num_blocks(game.size);
 
-  if(last_end != storage_size_blocks) {
     // insert empty space
-      StorageEntry empty_entry = {last_end, nullptr, nullptr};
-      storage_usage.emplace_back(empty_entry);
+    if(last_end != game.block)
+      add_entry(storage_usage, last_end, game.block, nullptr, -1);
+
+    add_entry(storage_usage, game.block, end_block, game.metadata, i);
+
+    last_end = end_block;
   }
 
-  selected_entry = storage_usage.begin();
-}
+  // insert empty space
+  if(last_end != geometry.num_blocks)
+    add_entry(storage_usage, last_end, geometry.num_blocks, nullptr, -1);
 
-void render(uint32_t time_ms) {
-  using namespace blit;
+  selected_entry = 0;
 
-  screen.pen = {20, 30, 40};
-  screen.clear();
+  plan_defrag();
 
-  // draw grid
-  auto size_with_border = block_tile_size + block_tile_border;
+  create_grid_surface();
 
-  int y_off = 10;
-  int x_off = (screen.bounds.w - (num_cols * size_with_border)) / 2;
+  init_us = blit::us_diff(start, blit::now_us());
+}
 
-  auto cur_entry = storage_usage.begin();
-  auto next_entry = std::next(cur_entry);
-  auto col = get_entry_colour(*cur_entry);
+// one tile per block, tiles for the same entry are joined up
+static void render_blocks(const StorageLayout &layout, blit::Surface &dest, blit::Point origin, int first_row, int last_row) {
+  using namespace blit;
 
-  // tile cur item started in
-  int start_x = 0, start_y = 0;
+  auto size_with_border = block_tile_size + block_tile_border;
 
-  for(int y = 0; y < num_rows; y++) {
-    for(int x = 0; x < num_cols; x++) {
+  for(int y = first_row; y <= last_row; y++) {
+    for(int x = 0; x < grid.cols; x++) {
 
-      unsigned block_index = y * num_cols + x;
+      unsigned block_index = y * grid.cols + x;
 
-      // advance to next entry
-      if(next_entry != storage_usage.end() && next_entry->start_block == block_index) {
-        cur_entry = next_entry;
-        next_entry = std::next(cur_entry);
-        col = get_entry_colour(*cur_entry);
+      if(block_index >= geometry.num_blocks)
+        break;
 
-        start_x = x;
-        start_y = y;
-      }
+      int entry_index = layout.tiles[block_index].owner;
+      auto &entry = layout.entries[entry_index];
 
-      screen.pen = col;
+      // tile the entry starts/ends in
+      unsigned end_block = entry.start_block + entry.num_blocks;
+      int start_x = entry.start_block % grid.cols, start_y = entry.start_block / grid.cols;
+
+      set_pen(dest, get_entry_colour(entry));
 
       Rect r{
-        x_off + x * size_with_border, y_off + y * size_with_border,
+        origin.x + x * size_with_border, origin.y + y * size_with_border,
         block_tile_size, block_tile_size
       };
 
@@ -214,79 +719,345 @@ void render(uint32_t time_ms) {
         r.h += block_tile_border;
       }
 
-      screen.rectangle(r);
-
-      if(cur_entry->icon && x == start_x && y == start_y) {
-        // draw icon
-        screen.blit(cur_entry->icon, {0, 0, 8, 8}, {r.x, r.y});
-      }
+      dest.rectangle(r);
 
       // draw border around selected
-      if(cur_entry == selected_entry) {
-        screen.pen = {255, 255, 255};
+      if(entry_index == selected_entry) {
+        set_pen(dest, {255, 255, 255});
 
         // left
         if(x == 0 || (x == start_x && y == start_y))
-          screen.v_span({r.x - 1, r.y}, size_with_border);
+          dest.v_span({r.x - 1, r.y}, size_with_border);
 
         // right
-        if(x == num_cols - 1 || (next_entry != storage_usage.end() && next_entry->start_block == block_index + 1))
-          screen.v_span({r.x + r.w, r.y}, size_with_border);
+        if(x == grid.cols - 1 || end_block == block_index + 1)
+          dest.v_span({r.x + r.w, r.y}, size_with_border);
 
         // top
         if(y == start_y || (y == start_y + 1 && x < start_x))
-          screen.h_span({r.x - 1, r.y - 1}, r.w + 2);
+          dest.h_span({r.x - 1, r.y - 1}, r.w + 2);
 
         // bottom
-        int end_x = num_cols - 1, end_y = num_rows - 1;
-        if(next_entry != storage_usage.end()) {
-          end_x = next_entry->start_block % num_cols;
-          end_y = next_entry->start_block / num_cols;
-        }
+        int end_x = end_block % grid.cols, end_y = end_block / grid.cols;
 
         if(y == end_y || (y == end_y - 1 && x >= end_x))
-          screen.h_span({r.x - 1, r.y +r.h}, r.w + 2);
+          dest.h_span({r.x - 1, r.y +r.h}, r.w + 2);
+      }
+    }
+  }
+}
+
+// icons at the start of each entry, only loading the selected one
+// (only in the rows being copied, if any)
+static void render_icons(const StorageLayout &layout, blit::Point origin, const std::vector<uint8_t> *rows = nullptr) {
+  auto size_with_border = block_tile_size + block_tile_border;
+
+  for(unsigned i = 0; i < layout.entries.size(); i++) {
+    auto &entry = layout.entries[i];
+
+    if(entry.game < 0)
+      continue;
+
+    if(rows && !(*rows)[entry.start_block / grid.cols])
+      continue;
+
+    auto &game = installed_games[entry.game];
+    auto icon = int(i) == selected_entry ? load_icon(game) : icon_cache.find(game.icon_data);
+
+    if(icon) {
+      blit::Point pos(origin.x + entry.start_block % grid.cols * size_with_border, origin.y + entry.start_block / grid.cols * size_with_border);
+      blit::screen.blit(icon, {0, 0, 8, 8}, pos);
+    }
+  }
+}
+
+// each tile is filled up to how much of it is used, in the colour of the entry using the most of it
+static void render_tiles(const StorageLayout &layout, blit::Surface &dest, blit::Point origin, int first_row, int last_row) {
+  using namespace blit;
+
+  auto size_with_border = block_tile_size + block_tile_border;
+
+  auto &selected = layout.entries[selected_entry];
+  auto selected_end = selected.start_block + selected.num_blocks;
+
+  auto end_tile = std::min(grid.num_tiles, uint32_t(last_row + 1) * grid.cols);
+
+  for(uint32_t i = first_row * grid.cols; i < end_tile; i++) {
+    auto &tile = layout.tiles[i];
+
+    auto tile_start = i * grid.blocks_per_tile;
+    auto tile_blocks = std::min(grid.blocks_per_tile, geometry.num_blocks - tile_start);
+
+    Rect r{
+      origin.x + int(i % grid.cols) * size_with_border, origin.y + int(i / grid.cols) * size_with_border,
+      block_tile_size, block_tile_size
+    };
+
+    set_pen(dest, {100, 100, 100});
+    dest.rectangle(r);
+
+    if(tile.used_blocks) {
+      int h = std::max(1, int(tile.used_blocks * block_tile_size / tile_blocks));
+      set_pen(dest, get_entry_colour(layout.entries[tile.owner]));
+      dest.rectangle({r.x, r.y + r.h - h, r.w, h});
+    }
+
+    if(selected.start_block < tile_start + tile_blocks && selected_end > tile_start) {
+      set_pen(dest, {255, 255, 255});
+      dest.h_span({r.x - 1, r.y - 1}, r.w + 2);
+      dest.h_span({r.x - 1, r.y + r.h}, r.w + 2);
+      dest.v_span({r.x - 1, r.y}, r.h);
+      dest.v_span({r.x + r.w, r.y}, r.h);
+    }
+  }
+}
+
+static void render_grid(const StorageLayout &layout, blit::Surface &dest, blit::Point origin, int first_row, int last_row) {
+  if(grid.blocks_per_tile == 1)
+    render_blocks(layout, dest, origin, first_row, last_row);
+  else
+    render_tiles(layout, dest, origin, first_row, last_row);
+}
+
+// only redraws the rows an entry is in (and the gaps around them), the rows
+// either side are drawn too as their borders/joins overlap
+static void repaint_entry(const StorageLayout &layout, int entry_index) {
+  auto size_with_border = block_tile_size + block_tile_border;
+
+  auto &entry = layout.entries[entry_index];
+  int first_row = entry.start_block / grid.blocks_per_tile / grid.cols;
+  int last_row = (entry.start_block + entry.num_blocks - 1) / grid.blocks_per_tile / grid.cols;
+
+  grid_surface->clip = {0, first_row * size_with_border, grid_surface->bounds.w, (last_row - first_row + 1) * size_with_border + 1};
+  set_pen(*grid_surface, background_colour);
+  grid_surface->rectangle(grid_surface->clip);
+
+  first_row = std::max(0, first_row - 1);
+  last_row = std::min(grid.rows - 1, last_row + 1);
+  render_grid(layout, *grid_surface, {1, 1}, first_row, last_row);
+
+  grid_surface->clip = {{0, 0}, grid_surface->bounds};
+
+  for(int row = first_row; row <= last_row; row++)
+    grid_rows_to_copy[row] = grid_copy_frames;
+}
+
+static void update_grid_surface(const StorageLayout &layout) {
+  if(grid_dirty) {
+    set_pen(*grid_surface, background_colour);
+    grid_surface->clear();
+
+    render_grid(layout, *grid_surface, {1, 1}, 0, grid.rows - 1);
+
+    grid_rows_to_copy.assign(grid.rows, grid_copy_frames);
+    grid_dirty = false;
+  } else {
+    for(auto entry : dirty_entries)
+      repaint_entry(layout, entry);
+  }
+
+  dirty_entries.clear();
+}
+
+void render(uint32_t time_ms) {
+  using namespace blit;
+
+  auto start = now_us();
+
+  auto &usage = show_simulated ? sim_usage : storage_usage;
+
+  // draw grid
+  auto size_with_border = block_tile_size + block_tile_border;
+
+  if(retained_render && grid_surface) {
+    update_grid_surface(usage);
+
+    // ran out of colours, give up on it
+    if(grid_palette_full)
+      free_grid_surface();
+  }
+
+  screen.pen = background_colour;
+
+  if(retained_render && grid_surface) {
+    // the grid is left on the screen, so clear around it
+    Rect grid_rect({grid.x - 1, grid_y - 1}, grid_surface->bounds);
+    int grid_bottom = grid_rect.y + grid_rect.h, grid_right = grid_rect.x + grid_rect.w;
+
+    screen.rectangle({0, 0, screen.bounds.w, grid_rect.y});
+    screen.rectangle({0, grid_rect.y, grid_rect.x, grid_rect.h});
+    screen.rectangle({grid_right, grid_rect.y, screen.bounds.w - grid_right, grid_rect.h});
+    screen.rectangle({0, grid_bottom, screen.bounds.w, screen.bounds.h - grid_bottom});
+
+    // then copy the changed rows, a run at a time
+    for(int row = 0; row < grid.rows;) {
+      if(!grid_rows_to_copy[row]) {
+        row++;
+        continue;
       }
+
+      int first_row = row;
+      while(row < grid.rows && grid_rows_to_copy[row])
+        row++;
+
+      // + the border below
+      Rect src(0, first_row * size_with_border, grid_rect.w, (row - first_row) * size_with_border + 1);
+      screen.blit(grid_surface, src, {grid_rect.x, grid_rect.y + src.y});
     }
+
+    if(grid.blocks_per_tile == 1)
+      render_icons(usage, {grid.x, grid_y}, &grid_rows_to_copy);
+
+    for(auto &count : grid_rows_to_copy) {
+      if(count)
+        count--;
+    }
+  } else {
+    screen.clear();
+    render_grid(usage, screen, {grid.x, grid_y}, 0, grid.rows - 1);
+
+    if(grid.blocks_per_tile == 1)
+      render_icons(usage, {grid.x, grid_y});
   }
 
   // show game info
   screen.pen = {255, 255, 255};
 
-  int meta_y = y_off + num_rows * size_with_border + 10;
+  int x_off = grid.x;
+  int meta_y = grid_y + grid.rows * size_with_border + 10;
+
+  auto &selected = usage.entries[selected_entry];
 
-  if(selected_entry->metadata) {
-    screen.text(selected_entry->metadata->title, minimal_font, {x_off, meta_y});
-    screen.text(selected_entry->metadata->author, minimal_font, {x_off, meta_y + 10});
-    screen.text(selected_entry->metadata->version, minimal_font, {x_off, meta_y + 20});
+  if(selected.metadata) {
+    screen.text(selected.metadata->title, minimal_font, {x_off, meta_y});
+    screen.text(selected.metadata->author, minimal_font, {x_off, meta_y + 10});
+    screen.text(selected.metadata->version, minimal_font, {x_off, meta_y + 20});
   } else {
     screen.text("Empty", minimal_font, {x_off, meta_y});
   }
 
   // display size of selected
-  next_entry = std::next(selected_entry);
-  uint16_t end_block = next_entry == storage_usage.end() ? storage_size_blocks : next_entry->start_block;
-
-  int size_blocks = end_block - selected_entry->start_block;
+  int size_blocks = selected.num_blocks;
   char buf[100];
-  snprintf(buf, sizeof(buf), "%i blocks\n(%lukB)\n", size_blocks, size_blocks * storage_block_size / 1024);
+  snprintf(buf, sizeof(buf), "%i blocks\n(%ukB)\n", size_blocks, unsigned(uint64_t(size_blocks) * geometry.block_size / 1024));
 
   int right_x_off = screen.bounds.w - x_off;
   screen.text(buf, minimal_font, {right_x_off, meta_y}, true, TextAlign::top_right);
+
+  // icon memory, and roughly what loading them all at startup would cost
+  unsigned num_loaded = icon_cache.get_num_loaded();
+  unsigned num_decoded = icon_cache.get_num_decoded();
+  unsigned avg_size = num_loaded ? icon_cache.get_bytes_used() / num_loaded : 0;
+  unsigned avg_decode_us = num_decoded ? icon_cache.get_decode_us() / num_decoded : 0;
+
+  screen.pen = {200, 200, 200};
+  snprintf(buf, sizeof(buf), "Init %uus, icons %u/%u %ukB (all: %ukB +%uus)", unsigned(init_us), num_loaded, num_game_icons,
+           unsigned(icon_cache.get_bytes_used() / 1024), avg_size * num_game_icons / 1024, avg_decode_us * num_game_icons);
+  screen.text(buf, minimal_font, {x_off, 0});
+
+  // flash size/grid scale
+  snprintf(buf, sizeof(buf), "%ukB x %u", unsigned(geometry.block_size / 1024), unsigned(geometry.num_blocks));
+  if(grid.blocks_per_tile > 1)
+    snprintf(buf + strlen(buf), sizeof(buf) - strlen(buf), ", %u per tile", unsigned(grid.blocks_per_tile));
+
+  screen.text(buf, minimal_font, {right_x_off, meta_y + 20}, true, TextAlign::top_right);
+
+  // fragmentation info
+  int frag_y = meta_y + 35;
+
+  snprintf(buf, sizeof(buf), "Free: %u blocks, largest %u, %u gaps, frag %i%%", frag_stats.free_blocks, frag_stats.largest_free,
+           frag_stats.num_gaps, int(frag_stats.frag_index * 100.0f + 0.5f));
+  screen.text(buf, minimal_font, {x_off, frag_y});
+
+  snprintf(buf, sizeof(buf), "Gaps: 1:%u 2+:%u 4+:%u 8+:%u 16+:%u 32+:%u", frag_stats.gap_histogram[0], frag_stats.gap_histogram[1],
+           frag_stats.gap_histogram[2], frag_stats.gap_histogram[3], frag_stats.gap_histogram[4], frag_stats.gap_histogram[5]);
+  screen.text(buf, minimal_font, {x_off, frag_y + 10});
+
+  if(!simulation_ok)
+    snprintf(buf, sizeof(buf), "Compaction plan failed!");
+  else if(compaction_plan.moves.empty())
+    snprintf(buf, sizeof(buf), "No compaction needed");
+  else
+    snprintf(buf, sizeof(buf), "Compact: %i moves, %ukB to copy", int(compaction_plan.moves.size()),
+             unsigned(uint64_t(compaction_plan.blocks_to_copy) * geometry.block_size / 1024));
+  screen.text(buf, minimal_font, {x_off, frag_y + 20});
+
+  screen.pen = {255, 255, 255};
+  screen.text(show_simulated ? "B: current" : "B: compacted", minimal_font, {right_x_off, frag_y + 20}, true, TextAlign::top_right);
+
+  // CRC check progress/results
+  unsigned speed_kb = verify_us ? verify_bytes * 1000000 / 1024 / verify_us : 0;
+
+  if(crc_self_test_failed)
+    snprintf(buf, sizeof(buf), "CRC self test failed!");
+  else if(verifying) {
+    snprintf(buf, sizeof(buf), "Verifying %u/%u, %u.%02uMB/s", verify_game + 1, unsigned(installed_games.size()),
+             speed_kb / 1024, speed_kb % 1024 * 100 / 1024);
+  } else if(verify_done) {
+    snprintf(buf, sizeof(buf), "Checked %u, %u bad, %u saved%s %u.%02uMB/s", num_verified, num_bad, num_saved,
+             crc_save_failed ? " (failed!)" : "", speed_kb / 1024, speed_kb % 1024 * 100 / 1024);
+  } else
+    snprintf(buf, sizeof(buf), "A: verify");
+
+  screen.pen = num_bad || crc_self_test_failed || crc_save_failed ? Pen(255, 80, 80) : Pen(200, 200, 200);
+  screen.text(buf, minimal_font, {x_off, frag_y + 30});
+
+  snprintf(buf, sizeof(buf), "Y: %s %uus", retained_render ? "retained" : "immediate", unsigned(render_us_avg));
+  screen.pen = {200, 200, 200};
+  screen.text(buf, minimal_font, {right_x_off, frag_y + 30}, true, TextAlign::top_right);
+
+  render_us_total += us_diff(start, now_us());
+
+  if(++render_frames == render_average_frames) {
+    render_us_avg = render_us_total / render_frames;
+    render_us_total = 0;
+    render_frames = 0;
+  }
 }
 
 void update(uint32_t time_ms) {
 
-  if(blit::buttons.released & blit::Button::DPAD_LEFT) {
-    if(selected_entry == storage_usage.begin())
-      selected_entry = std::prev(storage_usage.end());
-    else
-      selected_entry--;
+  update_colours(colour_slice_us);
+
+  if(blit::buttons.released & blit::Button::A)
+    start_verify();
+
+  if(verifying)
+    update_verify(verify_slice_us);
+
+  // switch between the current and compacted layouts, keeping the selection
+  if((blit::buttons.released & blit::Button::B) && simulation_ok) {
+    if(show_simulated) {
+      int source = sim_source[selected_entry];
+      selected_entry = source == -1 ? 0 : source;
+    } else {
+      auto it = std::find(sim_source.begin(), sim_source.end(), selected_entry);
+      selected_entry = it == sim_source.end() ? 0 : it - sim_source.begin();
+    }
+
+    show_simulated = !show_simulated;
+    grid_dirty = true;
+  }
+
+  if(blit::buttons.released & blit::Button::Y) {
+    retained_render = !retained_render;
+    grid_dirty = true;
+    render_us_total = render_frames = 0;
   }
 
-  if(blit::buttons.released & blit::Button::DPAD_RIGHT) {
-    selected_entry++;
-    if(selected_entry == storage_usage.end())
-      selected_entry = storage_usage.begin();
+  int old_selected = selected_entry;
+
+  int num_entries = show_simulated ? sim_usage.entries.size() : storage_usage.entries.size();
+
+  if(blit::buttons.released & blit::Button::DPAD_LEFT)
+    selected_entry = selected_entry == 0 ? num_entries - 1 : selected_entry - 1;
+
+  if(blit::buttons.released & blit::Button::DPAD_RIGHT)
+    selected_entry = (selected_entry + 1) % num_entries;
+
+  // the immediate renderer draws everything anyway
+  if(selected_entry != old_selected && retained_render && grid_surface) {
+    dirty_entries.push_back(old_selected);
+    dirty_entries.push_back(selected_entry);
   }
 }
@@ -0,0 +1,176 @@
+#include <algorithm>
+
+#include "load-generator.hpp"
+
+#include "32blit.hpp"
+
+using namespace blit;
+
+enum class Param {
+  UpdateCost = 0,
+  RenderCost,
+  SpikeChance,
+  SpikeCost,
+};
+
+static const int num_params = 4;
+
+struct ParamInfo {
+  const char *label;
+  const char *format;
+  uint32_t step, max;
+};
+
+static const ParamInfo param_info[num_params]{
+  {"update cost",  "%5.1fms", 500,  50000}, // us
+  {"render cost",  "%5.1fms", 500,  50000},
+  {"spike chance", "%5.0f%%", 1,    100}, // per update
+  {"spike cost",   "%5.1fms", 5000, 200000},
+};
+
+static uint32_t params[num_params]{0, 0, 0, 50000};
+static int cur_param = 0;
+
+static const int max_updates_per_render = 8; // last bin is everything over
+
+// stats
+static uint32_t updates_since_render = 0;
+static uint32_t updates_per_render[max_updates_per_render + 1];
+static uint32_t max_updates_per_render_seen;
+
+static uint32_t backlog_ms, max_backlog_ms;
+static uint64_t total_backlog_ms;
+static uint32_t num_updates, num_spikes;
+
+// per second
+static uint32_t window_start;
+static uint32_t window_updates, window_renders, window_busy_us;
+static uint32_t update_rate, render_rate, busy_percent;
+
+static void burn_us(uint32_t us) {
+  auto start = now_us();
+  while(us_diff(start, now_us()) < us);
+}
+
+void reset_load_generator() {
+  updates_since_render = 0;
+  std::fill(std::begin(updates_per_render), std::end(updates_per_render), 0);
+  max_updates_per_render_seen = 0;
+
+  backlog_ms = max_backlog_ms = 0;
+  total_backlog_ms = 0;
+  num_updates = num_spikes = 0;
+
+  window_start = now();
+  window_updates = window_renders = window_busy_us = 0;
+  update_rate = render_rate = busy_percent = 0;
+}
+
+void update_load_generator(uint32_t time) {
+  auto start_us = now_us();
+
+  // how far behind the time we're being updated for are we
+  backlog_ms = now() - time;
+  max_backlog_ms = std::max(max_backlog_ms, backlog_ms);
+  total_backlog_ms += backlog_ms;
+  num_updates++;
+  updates_since_render++;
+
+  // adjust params
+  if(buttons.pressed & Button::DPAD_UP)
+    cur_param = cur_param == 0 ? num_params - 1 : cur_param - 1;
+  else if(buttons.pressed & Button::DPAD_DOWN)
+    cur_param = (cur_param + 1) % num_params;
+
+  auto &param = params[cur_param];
+  auto &info = param_info[cur_param];
+
+  if((buttons.pressed & Button::DPAD_LEFT) && param >= info.step)
+    param -= info.step;
+  else if((buttons.pressed & Button::DPAD_RIGHT) && param + info.step <= info.max)
+    param += info.step;
+
+  if(buttons.pressed & Button::A)
+    reset_load_generator();
+
+  burn_us(params[int(Param::UpdateCost)]);
+
+  if(blit::random() % 100 < params[int(Param::SpikeChance)]) {
+    burn_us(params[int(Param::SpikeCost)]);
+    num_spikes++;
+  }
+
+  window_updates++;
+  window_busy_us += us_diff(start_us, now_us());
+}
+
+void render_load_generator() {
+  auto start_us = now_us();
+
+  updates_per_render[std::min(updates_since_render, uint32_t(max_updates_per_render))]++;
+  max_updates_per_render_seen = std::max(max_updates_per_render_seen, updates_since_render);
+  updates_since_render = 0;
+
+  // rates over the last second
+  if(now() - window_start >= 1000) {
+    auto elapsed = now() - window_start;
+    update_rate = window_updates * 1000 / elapsed;
+    render_rate = window_renders * 1000 / elapsed;
+    busy_percent = window_busy_us / (elapsed * 10);
+
+    window_start = now();
+    window_updates = window_renders = window_busy_us = 0;
+  }
+
+  char buf[100];
+
+  screen.text("UP/DOWN: select LEFT/RIGHT: adjust A: reset", minimal_font, {4, 20}, false);
+
+  for(int i = 0; i < num_params; i++) {
+    auto &info = param_info[i];
+
+    // everything but the percentage is in us
+    float value = info.step == 1 ? params[i] : params[i] / 1000.0f;
+
+    int len = snprintf(buf, sizeof(buf), "%c %-14s", i == cur_param ? '>' : ' ', info.label);
+    snprintf(buf + len, sizeof(buf) - len, info.format, double(value));
+    screen.text(buf, minimal_font, {4, 35 + i * 10}, false);
+  }
+
+  snprintf(buf, sizeof(buf), "update/s %4u render/s %4u busy %3u%%", update_rate, render_rate, busy_percent);
+  screen.text(buf, minimal_font, {4, 85}, false);
+
+  snprintf(buf, sizeof(buf), "backlog now %4ums max %4ums mean %6.1fms", backlog_ms, max_backlog_ms,
+           num_updates ? double(total_backlog_ms) / num_updates : 0.0);
+  screen.text(buf, minimal_font, {4, 95}, false);
+
+  snprintf(buf, sizeof(buf), "spikes %u, most updates per render %u", num_spikes, max_updates_per_render_seen);
+  screen.text(buf, minimal_font, {4, 105}, false);
+
+  // updates per render histogram
+  screen.text("updates per render", minimal_font, {4, 120}, false);
+
+  uint32_t hist_max = 1;
+  for(auto &count : updates_per_render)
+    hist_max = std::max(hist_max, count);
+
+  const int bar_w = 30, max_h = 80, chart_y = 132;
+
+  for(int i = 0; i <= max_updates_per_render; i++) {
+    int x = 4 + i * (bar_w + 4);
+    int h = updates_per_render[i] * max_h / hist_max;
+
+    // two 10ms updates per 20ms render is keeping up
+    screen.pen = i <= 2 ? Pen(0, 160, 255) : Pen(255, 80, 80);
+    screen.rectangle({x, chart_y + max_h - h, bar_w, h});
+
+    screen.pen = Pen(255, 255, 255);
+    snprintf(buf, sizeof(buf), i == max_updates_per_render ? "%i+" : "%i", i);
+    screen.text(buf, minimal_font, {x + bar_w / 2, chart_y + max_h + 2}, true, TextAlign::top_center);
+  }
+
+  burn_us(params[int(Param::RenderCost)]);
+
+  window_renders++;
+  window_busy_us += us_diff(start_us, now_us());
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Burns a configurable amount of time in update/render (plus random spikes)
+// and records how the fixed update rate catches up.
+
+void reset_load_generator();
+
+void update_load_generator(uint32_t time);
+void render_load_generator();
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <string>
+
+#include "soak-test.hpp"
+
+#include "32blit.hpp"
+#include "engine/api_private.hpp"
+
+using namespace blit;
+
+static const char *log_filename = "timing-soak.log";
+static const uint32_t log_interval = 60 * 1000; // ms
+
+// now() and now_us() can each be up to 1ms apart, plus whatever happens between reading them
+static const uint32_t max_error_us = 2000;
+
+static const int max_events = 8;
+
+static bool started = false;
+static uint32_t start_ms;
+static uint32_t prev_ms, prev_us;
+
+static uint64_t total_ms, total_us;
+static int64_t drift_us, min_drift_us, max_drift_us;
+
+static uint32_t num_samples;
+static uint32_t num_wraps, last_wrap_ms, wrap_period_ms;
+static uint32_t ms_backwards, us_backwards, us_jumps, wrap_glitches;
+
+static uint32_t last_log_ms;
+static bool log_ok;
+
+static std::string events[max_events];
+static int num_events;
+
+static void format_elapsed(char *buf, size_t len, uint64_t ms) {
+  auto secs = ms / 1000;
+  snprintf(buf, len, "%3u:%02u:%02u", unsigned(secs / 3600), unsigned(secs / 60 % 60), unsigned(secs % 60));
+}
+
+static void write_log(const std::string &line) {
+  auto mode = file_exists(log_filename) ? OpenMode::read | OpenMode::write : OpenMode::write;
+  File f(log_filename, mode);
+
+  auto offset = f.get_length();
+  log_ok = f.write(offset, line.length(), line.c_str()) == int32_t(line.length());
+}
+
+static void add_event(const char *what, uint32_t expected_us, uint32_t actual_us) {
+  char buf[100], elapsed[16];
+  format_elapsed(elapsed, sizeof(elapsed), total_ms);
+
+  snprintf(buf, sizeof(buf), "%s %s: %uus, expected %uus", elapsed, what, unsigned(actual_us), unsigned(expected_us));
+
+  // keep the most recent on screen
+  for(int i = max_events - 1; i > 0; i--)
+    events[i] = events[i - 1];
+
+  events[0] = buf;
+  if(num_events < max_events)
+    num_events++;
+
+  write_log(std::string(buf) + "\n");
+}
+
+static void log_summary() {
+  char buf[150], elapsed[16];
+  format_elapsed(elapsed, sizeof(elapsed), total_ms);
+
+  snprintf(buf, sizeof(buf), "%s summary: samples %u wraps %u (period %ums) ms backwards %u us backwards %u us jumps %u wrap glitches %u drift %lldus (%lld to %lld)\n",
+           elapsed, unsigned(num_samples), unsigned(num_wraps), unsigned(wrap_period_ms), unsigned(ms_backwards),
+           unsigned(us_backwards), unsigned(us_jumps), unsigned(wrap_glitches), (long long)drift_us, (long long)min_drift_us, (long long)max_drift_us);
+
+  write_log(buf);
+}
+
+void start_soak_test() {
+  started = false;
+  num_events = 0;
+}
+
+void update_soak_test(uint32_t time) {
+  // read these as close together as possible
+  auto cur_ms = now();
+  auto cur_us = now_us();
+
+  if(!started) {
+    started = true;
+    start_ms = last_log_ms = prev_ms = cur_ms;
+    prev_us = cur_us;
+
+    total_ms = total_us = 0;
+    drift_us = min_drift_us = max_drift_us = 0;
+    num_samples = num_wraps = last_wrap_ms = wrap_period_ms = 0;
+    ms_backwards = us_backwards = us_jumps = wrap_glitches = 0;
+
+    char buf[100];
+    snprintf(buf, sizeof(buf), "start at %ums/%uus, max us timer %u\n", unsigned(cur_ms), unsigned(cur_us), unsigned(api.get_max_us_timer()));
+    write_log(buf);
+    return;
+  }
+
+  num_samples++;
+
+  uint32_t ms_delta = cur_ms - prev_ms;
+
+  // a "huge" step is really a negative one
+  if(ms_delta > 0x80000000) {
+    ms_backwards++;
+    add_event("ms went backwards", 0, 0);
+
+    // nothing useful to compare the us timer to, start again from here
+    prev_ms = cur_ms;
+    prev_us = cur_us;
+    return;
+  }
+
+  uint32_t expected_us = ms_delta * 1000;
+  uint32_t us_delta = us_diff(prev_us, cur_us);
+  uint32_t error_us = us_delta > expected_us ? us_delta - expected_us : expected_us - us_delta;
+
+  // going backwards is only a wrap if we were near the top of the timer,
+  // or the wrapped difference is about what the ms timer says
+  bool wrapped = false;
+
+  if(cur_us < prev_us) {
+    wrapped = api.get_max_us_timer() - prev_us <= expected_us + max_error_us || error_us <= max_error_us;
+
+    if(!wrapped) {
+      us_backwards++;
+      add_event("us went backwards", prev_us + expected_us, cur_us);
+
+      // not a real step, leave the drift alone
+      us_delta = expected_us;
+      error_us = 0;
+    }
+  }
+
+  if(wrapped) {
+    num_wraps++;
+
+    if(last_wrap_ms)
+      wrap_period_ms = cur_ms - last_wrap_ms;
+
+    last_wrap_ms = cur_ms;
+  }
+
+  // check against the ms timer
+  if(error_us > max_error_us) {
+    if(wrapped) {
+      wrap_glitches++;
+      add_event("wrap glitch", expected_us, us_delta);
+    } else {
+      us_jumps++;
+      add_event("us jump", expected_us, us_delta);
+    }
+
+    // don't let one glitch throw off the drift forever
+    us_delta = expected_us;
+  }
+
+  total_ms += ms_delta;
+  total_us += us_delta;
+
+  drift_us = int64_t(total_us) - int64_t(total_ms * 1000);
+  min_drift_us = std::min(min_drift_us, drift_us);
+  max_drift_us = std::max(max_drift_us, drift_us);
+
+  prev_ms = cur_ms;
+  prev_us = cur_us;
+
+  if(cur_ms - last_log_ms >= log_interval) {
+    log_summary();
+    last_log_ms = cur_ms;
+  }
+}
+
+void render_soak_test() {
+  char buf[100], elapsed[16];
+
+  format_elapsed(elapsed, sizeof(elapsed), total_ms);
+
+  snprintf(buf, sizeof(buf), "running %s              A: restart", elapsed);
+  screen.text(buf, minimal_font, {4, 20}, false);
+
+  snprintf(buf, sizeof(buf), "max us timer  %10u", unsigned(api.get_max_us_timer()));
+  screen.text(buf, minimal_font, {4, 35}, false);
+
+  snprintf(buf, sizeof(buf), "samples       %10u", unsigned(num_samples));
+  screen.text(buf, minimal_font, {4, 45}, false);
+
+  snprintf(buf, sizeof(buf), "us wraps      %10u (every %ums)", unsigned(num_wraps), unsigned(wrap_period_ms));
+  screen.text(buf, minimal_font, {4, 55}, false);
+
+  // anything non-zero here is bad
+  screen.pen = ms_backwards || us_backwards || us_jumps || wrap_glitches ? Pen(255, 80, 80) : Pen(255, 255, 255);
+
+  snprintf(buf, sizeof(buf), "ms backwards  %10u", unsigned(ms_backwards));
+  screen.text(buf, minimal_font, {4, 65}, false);
+
+  snprintf(buf, sizeof(buf), "us backwards  %10u", unsigned(us_backwards));
+  screen.text(buf, minimal_font, {4, 75}, false);
+
+  snprintf(buf, sizeof(buf), "us jumps      %10u", unsigned(us_jumps));
+  screen.text(buf, minimal_font, {4, 85}, false);
+
+  snprintf(buf, sizeof(buf), "wrap glitches %10u", unsigned(wrap_glitches));
+  screen.text(buf, minimal_font, {4, 95}, false);
+
+  screen.pen = Pen(255, 255, 255);
+
+  snprintf(buf, sizeof(buf), "us - ms drift %10lldus (%lld to %lld)", (long long)drift_us, (long long)min_drift_us, (long long)max_drift_us);
+  screen.text(buf, minimal_font, {4, 105}, false);
+
+  snprintf(buf, sizeof(buf), "log %s %s", log_filename, log_ok ? "" : "(write failed!)");
+  screen.text(buf, minimal_font, {4, 120}, false);
+
+  screen.text("recent events:", minimal_font, {4, 135}, false);
+
+  for(int i = 0; i < num_events; i++)
+    screen.text(events[i], minimal_font, {4, 145 + i * 10}, false);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Long running check of now()/now_us(), including across us timer wraps.
+// Results are appended to timing-soak.log as it goes.
+
+void start_soak_test();
+
+void update_soak_test(uint32_t time);
+void render_soak_test();
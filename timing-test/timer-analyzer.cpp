@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cmath>
+
+#include "timer-analyzer.hpp"
+
+#include "32blit.hpp"
+
+using namespace blit;
+
+static const int max_timers = 256;
+static const int num_steps = 9; // 1, 2, 4 ... 256 timers
+static const uint32_t step_duration = 2000; // ms
+
+static const int num_periods = 7;
+static const uint32_t periods[num_periods]{1, 2, 5, 10, 16, 33, 100};
+
+// callbacks less than this apart are assumed to be the same dispatch loop
+static const uint32_t same_pass_us = 100;
+
+struct TimerInfo {
+  uint32_t period_us;
+  bool fired;
+  uint32_t last_fire_us;
+  uint32_t count; // intervals
+  uint64_t total_us;
+  uint64_t total_sq_us;
+  uint32_t max_error_us;
+};
+
+struct StepResult {
+  uint32_t dispatch_us; // mean per frame
+  uint32_t max_dispatch_us;
+  float drift_us; // mean of each timer's abs(mean interval - period)
+  float jitter_us; // mean of each timer's std deviation
+};
+
+static Timer timers[max_timers];
+static TimerInfo timer_info[max_timers];
+static int num_timers = 0;
+
+static StepResult results[num_steps];
+static int cur_step = 0;
+static uint32_t step_start = 0;
+
+// dispatch time
+static uint32_t last_callback_exit_us = 0;
+static uint32_t frame_dispatch_us = 0;
+static uint64_t step_dispatch_us = 0;
+static uint32_t step_frames = 0;
+static uint32_t step_max_dispatch_us = 0;
+
+static void analyzer_timer_callback(Timer &t) {
+  auto entry_us = now_us();
+  auto &info = *static_cast<TimerInfo *>(t.user_data);
+
+  if(info.fired) {
+    auto interval = us_diff(info.last_fire_us, entry_us);
+    auto error = interval > info.period_us ? interval - info.period_us : info.period_us - interval;
+
+    info.count++;
+    info.total_us += interval;
+    info.total_sq_us += uint64_t(interval) * interval;
+    info.max_error_us = std::max(info.max_error_us, error);
+  }
+
+  info.fired = true;
+  info.last_fire_us = entry_us;
+
+  // include the loop overhead between timers that fire together
+  auto gap = us_diff(last_callback_exit_us, entry_us);
+  if(gap < same_pass_us)
+    frame_dispatch_us += gap;
+
+  last_callback_exit_us = now_us();
+  frame_dispatch_us += us_diff(entry_us, last_callback_exit_us);
+}
+
+static void get_timer_stats(const TimerInfo &info, float &drift, float &jitter) {
+  if(!info.count) {
+    drift = jitter = 0.0f;
+    return;
+  }
+
+  float mean = float(info.total_us) / info.count;
+  float variance = float(info.total_sq_us) / info.count - mean * mean;
+
+  drift = mean - info.period_us;
+  jitter = std::sqrt(std::max(variance, 0.0f));
+}
+
+static void start_timers(int count) {
+  for(int i = 0; i < num_timers; i++)
+    timers[i].stop();
+
+  num_timers = count;
+
+  for(int i = 0; i < num_timers; i++) {
+    auto period = periods[i % num_periods];
+
+    timer_info[i] = {};
+    timer_info[i].period_us = period * 1000;
+
+    timers[i].init(analyzer_timer_callback, period, -1);
+    timers[i].user_data = &timer_info[i];
+    timers[i].start();
+  }
+
+  frame_dispatch_us = 0;
+  step_dispatch_us = 0;
+  step_frames = 0;
+  step_max_dispatch_us = 0;
+  step_start = now();
+}
+
+static void finish_step() {
+  auto &result = results[cur_step];
+
+  result.dispatch_us = step_frames ? step_dispatch_us / step_frames : 0;
+  result.max_dispatch_us = step_max_dispatch_us;
+  result.drift_us = result.jitter_us = 0.0f;
+
+  for(int i = 0; i < num_timers; i++) {
+    float drift, jitter;
+    get_timer_stats(timer_info[i], drift, jitter);
+
+    result.drift_us += std::abs(drift);
+    result.jitter_us += jitter;
+  }
+
+  result.drift_us /= num_timers;
+  result.jitter_us /= num_timers;
+}
+
+void start_timer_analyzer() {
+  cur_step = 0;
+  start_timers(1);
+}
+
+void stop_timer_analyzer() {
+  start_timers(0);
+}
+
+void update_timer_analyzer(uint32_t time) {
+  if(!num_timers || now() - step_start < step_duration)
+    return;
+
+  finish_step();
+
+  if(++cur_step == num_steps)
+    stop_timer_analyzer();
+  else
+    start_timers(1 << cur_step);
+}
+
+void render_timer_analyzer() {
+  // frame boundary for dispatch time
+  if(num_timers) {
+    step_dispatch_us += frame_dispatch_us;
+    step_frames++;
+    step_max_dispatch_us = std::max(step_max_dispatch_us, frame_dispatch_us);
+    frame_dispatch_us = 0;
+  }
+
+  char buf[100];
+
+  screen.pen = Pen(255, 255, 255);
+
+  if(num_timers)
+    snprintf(buf, sizeof(buf), "Running %i timers... (%i/%i)", num_timers, cur_step + 1, num_steps);
+  else
+    snprintf(buf, sizeof(buf), "Done, A: run again");
+  screen.text(buf, minimal_font, {4, 20}, false);
+
+  // live stats for the current count by period
+  screen.text("period timers   mean  drift jitter  max err", minimal_font, {4, 35}, false);
+
+  int y = 45;
+  for(int p = 0; p < num_periods; p++) {
+    int count = 0;
+    uint64_t intervals = 0, total = 0;
+    float drift_sum = 0.0f, jitter_sum = 0.0f;
+    uint32_t max_error = 0;
+
+    for(int i = p; i < num_timers; i += num_periods) {
+      auto &info = timer_info[i];
+      float drift, jitter;
+      get_timer_stats(info, drift, jitter);
+
+      count++;
+      intervals += info.count;
+      total += info.total_us;
+      drift_sum += drift;
+      jitter_sum += jitter;
+      max_error = std::max(max_error, info.max_error_us);
+    }
+
+    if(!count)
+      break;
+
+    float mean = intervals ? float(total) / intervals : 0.0f;
+
+    snprintf(buf, sizeof(buf), "%4ums %6i %6.0f %6.1f %6.1f %8u", periods[p], count, double(mean),
+             double(drift_sum / count), double(jitter_sum / count), max_error);
+    screen.text(buf, minimal_font, {4, y}, false);
+    y += 10;
+  }
+
+  // scaling, dispatch time is per frame
+  screen.text("   N dispatch    max drift   jit", minimal_font, {4, 120}, false);
+
+  int done = num_timers ? cur_step : num_steps;
+  uint32_t chart_max = 1;
+
+  for(int i = 0; i < done; i++)
+    chart_max = std::max(chart_max, results[i].dispatch_us);
+
+  const Rect chart(200, 130, 112, 90);
+  const int bar_w = chart.w / num_steps;
+
+  for(int i = 0; i < done; i++) {
+    auto &result = results[i];
+
+    screen.pen = Pen(255, 255, 255);
+    snprintf(buf, sizeof(buf), "%4i %6uus %6u %5.0f %5.0f", 1 << i, result.dispatch_us, result.max_dispatch_us,
+             double(result.drift_us), double(result.jitter_us));
+    screen.text(buf, minimal_font, {4, 130 + i * 10}, false);
+
+    int h = result.dispatch_us * chart.h / chart_max;
+    screen.pen = Pen(0, 160, 255);
+    screen.rectangle({chart.x + i * bar_w, chart.y + chart.h - h, bar_w - 1, h});
+  }
+
+  screen.pen = Pen(80, 90, 100);
+  screen.h_span({chart.x, chart.y + chart.h}, chart.w);
+}
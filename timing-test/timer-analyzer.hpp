@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Runs 1-256 timers with mixed periods, measuring how far each one's
+// intervals are from the nominal period and how long dispatching takes.
+
+void start_timer_analyzer();
+void stop_timer_analyzer();
+
+void update_timer_analyzer(uint32_t time);
+void render_timer_analyzer();
@@ -1,4 +1,9 @@
+#include <algorithm>
+
 #include "timing-test.hpp"
+#include "load-generator.hpp"
+#include "soak-test.hpp"
+#include "timer-analyzer.hpp"
 
 using namespace blit;
 
@@ -16,8 +21,131 @@ static uint32_t display_fake_last_update, display_real_last_update;
 
 static bool paused = false, slow_render = false;
 
+enum class Page {
+  Overview = 0,
+  Timers,
+  Load,
+  Soak
+};
+
+static const int num_pages = 4;
+static Page page = Page::Overview;
+
 static Timer timer_100ms, timer_10ms, timer_1ms;
 
+// frame interval history
+static const int history_size = 256;
+static const int hist_bins = 40; // 1ms each, last is everything over
+
+struct IntervalHistory {
+  uint32_t intervals[history_size];
+  int count = 0, next = 0;
+  uint32_t last_time_us = 0;
+  bool started = false;
+  uint32_t nominal_us;
+  uint32_t missed = 0;
+
+  IntervalHistory(uint32_t nominal_us) : nominal_us(nominal_us) {}
+
+  void add(uint32_t time_us) {
+    if(started) {
+      auto interval = us_diff(last_time_us, time_us);
+
+      intervals[next] = interval;
+      next = (next + 1) % history_size;
+      count = std::min(count + 1, history_size);
+
+      // how many whole slots were skipped
+      auto slots = (interval + nominal_us / 2) / nominal_us;
+      if(slots > 1)
+        missed += slots - 1;
+    }
+
+    last_time_us = time_us;
+    started = true;
+  }
+};
+
+struct IntervalStats {
+  uint32_t min, mean, p50, p95, p99, max;
+  uint32_t missed;
+  uint16_t hist[hist_bins];
+  uint16_t hist_max;
+};
+
+static IntervalHistory update_history(10000), render_history(20000);
+static IntervalStats display_update_stats, display_render_stats;
+
+static void calc_interval_stats(const IntervalHistory &history, IntervalStats &stats) {
+  stats = {};
+  stats.missed = history.missed;
+
+  if(!history.count)
+    return;
+
+  uint32_t sorted[history_size];
+  std::copy(history.intervals, history.intervals + history.count, sorted);
+  std::sort(sorted, sorted + history.count);
+
+  auto percentile = [&sorted, &history](int p) {
+    return sorted[(history.count - 1) * p / 100];
+  };
+
+  uint64_t total = 0;
+
+  for(int i = 0; i < history.count; i++) {
+    total += sorted[i];
+
+    int bin = std::min(sorted[i] / 1000, uint32_t(hist_bins - 1));
+    stats.hist[bin]++;
+    stats.hist_max = std::max(stats.hist_max, stats.hist[bin]);
+  }
+
+  stats.min = sorted[0];
+  stats.mean = total / history.count;
+  stats.p50 = percentile(50);
+  stats.p95 = percentile(95);
+  stats.p99 = percentile(99);
+  stats.max = sorted[history.count - 1];
+}
+
+static void render_interval_stats(const char *label, const IntervalStats &stats, int y) {
+  char buf[100];
+  auto ms = [](uint32_t us) {return double(us) / 1000.0;};
+
+  snprintf(buf, sizeof(buf), "%-7s%6.1f%6.1f%6.1f%6.1f%6.1f%6.1f%7u", label,
+           ms(stats.min), ms(stats.mean), ms(stats.p50), ms(stats.p95), ms(stats.p99), ms(stats.max), stats.missed);
+  screen.text(buf, minimal_font, {4, y}, false);
+}
+
+static void render_histogram(const char *label, const IntervalStats &stats, uint32_t nominal_us, Point pos) {
+  const int bar_w = 3, max_h = 40;
+
+  screen.pen = Pen(255, 255, 255);
+  screen.text(label, minimal_font, pos, false);
+  pos.y += 10;
+
+  for(int i = 0; i < hist_bins; i++) {
+    // highlight the expected interval
+    if(i == int(nominal_us / 1000))
+      screen.pen = Pen(0, 255, 0);
+    else if(i > int(nominal_us / 1000))
+      screen.pen = Pen(255, 80, 80);
+    else
+      screen.pen = Pen(0, 160, 255);
+
+    int h = stats.hist_max ? stats.hist[i] * max_h / stats.hist_max : 0;
+    screen.rectangle({pos.x + i * bar_w, pos.y + max_h - h, bar_w - 1, h});
+  }
+
+  screen.pen = Pen(80, 90, 100);
+  screen.h_span({pos.x, pos.y + max_h}, hist_bins * bar_w);
+
+  screen.pen = Pen(255, 255, 255);
+  screen.text("0", minimal_font, {pos.x, pos.y + max_h + 2}, false);
+  screen.text("40ms+", minimal_font, {pos.x + hist_bins * bar_w, pos.y + max_h + 2}, false, TextAlign::top_right);
+}
+
 
 static void timer_100_update(blit::Timer &t){
   num_timer100++;
@@ -47,8 +175,7 @@ void init() {
   timer_1ms.start();
 }
 
-void render(uint32_t time_ms) {
-  num_renders++;
+static void render_overview() {
   auto current_time = now();
   auto current_time_us = now_us();
 
@@ -62,14 +189,12 @@ void render(uint32_t time_ms) {
     display_num_timer1 = num_timer1;
     display_fake_last_update = fake_last_update;
     display_real_last_update = real_last_update;
-  }
 
-  screen.pen = Pen(20, 30, 40);
-  screen.clear();
-
-  screen.pen = Pen(255, 255, 255);
+    calc_interval_stats(update_history, display_update_stats);
+    calc_interval_stats(render_history, display_render_stats);
+  }
 
-  screen.text("A: slow update B: slow render X: Pause", minimal_font, {4, 4}, false);
+  screen.text("A: slow update B: slow render X: Pause Y: Next", minimal_font, {4, 4}, false);
 
   char buf[110];
 
@@ -102,6 +227,45 @@ void render(uint32_t time_ms) {
            display_num_timer100 * 100, display_num_timer100, display_num_timer10 * 10, display_num_timer10, display_num_timer1);
   screen.text(buf, minimal_font, {4, 90}, false);
 
+  // interval stats
+  screen.text("          min  mean   p50   p95   p99   max missed", minimal_font, {4, 125}, false);
+  render_interval_stats("update", display_update_stats, 135);
+  render_interval_stats("render", display_render_stats, 145);
+
+  render_histogram("update interval", display_update_stats, 10000, {20, 165});
+  render_histogram("render interval", display_render_stats, 20000, {180, 165});
+}
+
+void render(uint32_t time_ms) {
+  num_renders++;
+  render_history.add(now_us());
+
+  screen.pen = Pen(20, 30, 40);
+  screen.clear();
+
+  screen.pen = Pen(255, 255, 255);
+
+  switch(page) {
+    case Page::Overview:
+      render_overview();
+      break;
+
+    case Page::Timers:
+      screen.text("Timer scaling                        Y: Next", minimal_font, {4, 4}, false);
+      render_timer_analyzer();
+      break;
+
+    case Page::Load:
+      screen.text("Load generator                       Y: Next", minimal_font, {4, 4}, false);
+      render_load_generator();
+      break;
+
+    case Page::Soak:
+      screen.text("Soak test                            Y: Next", minimal_font, {4, 4}, false);
+      render_soak_test();
+      break;
+  }
+
 
   // fake a slow render
   if(slow_render) {
@@ -113,9 +277,45 @@ void render(uint32_t time_ms) {
 
 void update(uint32_t time) {
   num_updates++;
+  update_history.add(now_us());
   fake_last_update = time; //very fake
   real_last_update = now();
 
+  if(buttons.pressed & Button::Y) {
+    if(page == Page::Timers)
+      stop_timer_analyzer();
+
+    page = Page((int(page) + 1) % num_pages);
+
+    if(page == Page::Timers)
+      start_timer_analyzer();
+    else if(page == Page::Load)
+      reset_load_generator();
+    else if(page == Page::Soak)
+      start_soak_test();
+  }
+
+  if(page == Page::Timers) {
+    if(buttons.pressed & Button::A)
+      start_timer_analyzer();
+
+    update_timer_analyzer(time);
+    return;
+  }
+
+  if(page == Page::Load) {
+    update_load_generator(time);
+    return;
+  }
+
+  if(page == Page::Soak) {
+    if(buttons.pressed & Button::A)
+      start_soak_test();
+
+    update_soak_test(time);
+    return;
+  }
+
   if(buttons.pressed & Button::X)
     paused = !paused;
 